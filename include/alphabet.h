@@ -0,0 +1,56 @@
+#ifndef ALPHABET_H
+#define ALPHABET_H
+
+#include "patterns.h"
+
+// Symbol for characters which are not in any pattern
+#define ALPHABET_UNKNOWN 0xFF
+
+// Symbol 0 ends the key and ALPHABET_UNKNOWN is reserved
+#define ALPHABET_MAX_SIZE 254
+
+// Number of code points in one page of the lookup table
+#define ALPHABET_PAGE_SIZE 256
+#define ALPHABET_PAGE_COUNT (0x110000 / ALPHABET_PAGE_SIZE)
+
+/**
+ * Dense alphabet of one pattern set. Every code point used in patterns gets
+ * 1 byte symbol from 1 to size. ASCII characters are looked up directly, other
+ * code points through pages of 256 symbols, which are allocated only for used
+ * parts of unicode.
+ * Ex.: patterns .a1b and á2b give alphabet '.' = 1, 'a' = 2, 'b' = 3, 'á' = 4
+ */
+typedef struct
+{
+    unsigned char ascii[128];
+    unsigned char *pages[ALPHABET_PAGE_COUNT];
+    int size;
+} Alphabet;
+
+/**
+ * Derive alphabet from all characters of patterns. Returns 0 if everything
+ * went ok, returns 1 if patterns use more than ALPHABET_MAX_SIZE characters or
+ * allocation failed.
+ */
+int alphabet_create(Alphabet *alphabet, Pattern_wrapper *patterns);
+
+/**
+ * Rewrite words of all patterns to symbols of alphabet. Codes of patterns stay
+ * the same, because every character is replaced by exactly one symbol.
+ */
+void alphabet_transcode_patterns(Alphabet *alphabet, Pattern_wrapper *patterns);
+
+/**
+ * Write symbols of word into symbols, which must have space for at least
+ * strlen(word) + 1 bytes. Characters outside of alphabet are written as
+ * ALPHABET_UNKNOWN, so they never match any pattern. Returns count of symbols.
+ */
+int alphabet_transcode(Alphabet *alphabet, const char *word, unsigned char *symbols);
+
+// Returns symbol of code point or ALPHABET_UNKNOWN
+unsigned char alphabet_symbol(Alphabet *alphabet, int code_point);
+
+// Free all pages of alphabet
+void alphabet_free(Alphabet *alphabet);
+
+#endif // !ALPHABET_H
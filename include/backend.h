@@ -0,0 +1,75 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include "patterns.h"
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Number of words hyphenated by every backend when backends are measured
+#define BACKEND_SAMPLE_COUNT 2000
+
+// Longest sample word in bytes, Judy and cprops trie keep offsets in char
+#define BACKEND_MAXWORDBYTES 120
+
+// Number of patterns of subset which is built to estimate footprint of backend
+#define BACKEND_ESTIMATE_COUNT 2000
+
+// Indexes of backends in backends array
+typedef enum
+{
+    BACKEND_JUDY,
+    BACKEND_TRIE,
+    BACKEND_PACKED,
+    BACKEND_JUDY_TRIE,
+    BACKEND_COUNT
+} Backend_kind;
+
+/**
+ * Data structure which can hyphenate words with patterns. New data structures
+ * from compare program should be added to the backends array, so they are
+ * measured by bench and can be selected by hyphenator.
+ */
+typedef struct
+{
+    const char *name;
+    void *(*create)(Pattern_wrapper *patterns);
+    char *(*hyphenate)(char *word, void *structure, const char *utf8_code);
+    void (*destroy)(void *structure);
+} Backend;
+
+/**
+ * Footprint and cost of one backend measured by backend_select. Estimate is
+ * footprint extrapolated from subset of patterns or 0 if it was not estimated.
+ */
+typedef struct
+{
+    size_t estimate;
+    size_t bytes;
+    double usec_per_word;
+    bool measured;
+} Backend_measure;
+
+// All backends, indexed by Backend_kind
+extern const Backend backends[BACKEND_COUNT];
+
+/**
+ * Build every backend from patterns, measure its heap footprint and average
+ * time of hyphenation of sample words after one untimed warm-up pass, then
+ * destroy it again. With max_bytes the footprint of every backend is first
+ * estimated from BACKEND_ESTIMATE_COUNT patterns and backends estimated over
+ * max_bytes are not built, if none fits, only the smallest one is built.
+ * Sample words are BACKEND_SAMPLE_COUNT words spread over file_name, if it is
+ * not NULL, otherwise they are made of letters of patterns. The fastest
+ * backend, which needs at most max_bytes and hyphenates word in at most
+ * max_usec, is chosen. Limit 0 means no limit. If no backend meets both, the
+ * fastest one within max_bytes is chosen, if none fits into max_bytes, the
+ * smallest one, and warning is printed to stderr. Figures are written to
+ * measures, backends which were not measured have measured set to false.
+ * Returns chosen Backend_kind or -1 if no backend could be built or
+ * allocation failed.
+ */
+int backend_select(Pattern_wrapper *patterns, const char *file_name, size_t max_bytes,
+                   double max_usec, Backend_measure measures[BACKEND_COUNT]);
+
+#endif // !BACKEND_H
@@ -0,0 +1,64 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "patterns.h"
+
+/**
+ * Distribution of lengths of generated words in characters. Lengths are
+ * uniform between min and max, or if histogram is not NULL, histogram[l] is
+ * the number of words with l characters in a word list and lengths are drawn
+ * in the same proportion. Label names the distribution in output and files.
+ */
+typedef struct
+{
+    char label[32];
+    int min;
+    int max;
+    long *histogram;
+} Bench_lengths;
+
+/**
+ * Generate count unique random patterns over an alphabet of alphabet_size
+ * characters, where every character takes char_bytes bytes in UTF-8 (1, 2 or
+ * 3). Patterns are stored the same way as patterns_load stores them, so the
+ * result must be freed with patterns_free. Returns 0 if everything went ok,
+ * returns 1 if allocation failed.
+ */
+int bench_generate_patterns(Pattern_wrapper *patterns, int count, int char_bytes,
+                            int alphabet_size, unsigned int *seed);
+
+/**
+ * Load histogram of lengths of words in characters from word_file (.dic
+ * format) into lengths, words longer than max_length are not counted. The
+ * histogram must be freed later. Returns 0 if everything went ok, returns 1 if
+ * file was not opened correctly, allocation failed or no word was counted.
+ */
+int bench_load_lengths(Bench_lengths *lengths, const char *word_file, int max_length);
+
+/**
+ * Generate count random words from the same alphabet as
+ * bench_generate_patterns with lengths drawn from lengths. Lengths over
+ * max_length are not drawn, lengths->min must not be over it. Returns
+ * allocated array of allocated words or NULL if allocation failed.
+ */
+char **bench_generate_words(int count, const Bench_lengths *lengths, int max_length,
+                            int char_bytes, int alphabet_size, unsigned int *seed);
+
+/**
+ * Hyphenate all words with every backend and print one result line per
+ * backend with mean length and mean number of probes of words. Words are
+ * expected to be without dots, label names their length distribution.
+ */
+void bench_run(Pattern_wrapper *patterns, char **words, int word_count, const char *label,
+               int char_bytes);
+
+/**
+ * Microbenchmark of merging pattern codes and extracting breaks. All patterns
+ * found in words from words_file are collected first, then they are merged
+ * and breaks are extracted with scalar and with vector functions from utils.
+ * Returns 0 if everything went ok, returns 1 if file was not opened correctly
+ * or allocation failed.
+ */
+int bench_merge(const char *patterns_file, const char *words_file);
+
+#endif // !BENCH_H
@@ -2,6 +2,9 @@
 #define COMPARE_H
 
 #include "patterns.h"
+#include "alphabet.h"
+#include "packed.h"
+#include "judytrie.h"
 
 #include <Judy.h>
 #include <stdbool.h>
@@ -14,6 +17,13 @@
  */
 void space_test_judy(Pattern_wrapper *pattern_list);
 
+/**
+ * This function inserts all patterns from pattern_list to Judy character trie
+ * and then free all of its memory. Should be run with Valgrind or other memory
+ * measuring software
+ */
+void space_test_judy_trie(Pattern_wrapper *pattern_list);
+
 /**
  * This function inserts all patterns from pattern_list to Cprops Trie and then
  * free all of its memory. Should be run with Valgrind or other memory measuring
@@ -22,10 +32,51 @@ void space_test_judy(Pattern_wrapper *pattern_list);
 void space_test_trie(Pattern_wrapper *pattern_list);
 
 /**
- * Load words from file_name and hyphenate them with patterns stored in judy and
- * in cprops trie. This proccess is timed.
+ * This function compiles all patterns from pattern_list to packed trie and
+ * then free all of its memory. Should be run with Valgrind or other memory
+ * measuring software
+ */
+void space_test_packed(Pattern_wrapper *pattern_list);
+
+/**
+ * Load all words from file_name and hyphenate them concurrently with 1, 2, 4
+ * and up to max_threads threads, every thread gets its own part of words and
+ * all threads read the same data structure. Throughput of all threads and
+ * average and maximum time per word of one thread are printed for every data
+ * structure which is not NULL. Cprops trie is measured also in synchronized
+ * mode as pattern_trie_sync.
+ */
+void compare_threads(const char *file_name, int max_threads, Pvoid_t *pattern_judy,
+                     cp_trie *pattern_trie, cp_trie *pattern_trie_sync,
+                     Packed_trie *pattern_packed, Judy_trie *pattern_judy_trie);
+
+/**
+ * Remove duplicate and dominated patterns from pattern_list and print count of
+ * patterns, memory of Judy and time of hyphenation of words from file_name
+ * before and after pruning. Hyphenation results of both are compared.
+ */
+void compare_pruned(const char *file_name, Pattern_wrapper *pattern_list);
+
+/**
+ * Compile packed trie from pattern_list, count hits of its nodes with words
+ * from profile_file and lay out its copy by the profile. Both tries hyphenate
+ * all words from file_name LAYOUT_REPEAT times and average time, cache misses
+ * (if hardware counters are available) and cache lines of hot nodes are
+ * printed. Hyphenation results of both are compared.
+ */
+void compare_profiled(const char *file_name, const char *profile_file,
+                      Pattern_wrapper *pattern_list);
+
+/**
+ * Load words from file_name and hyphenate them with patterns stored in judy,
+ * in cprops trie, in packed trie and in Judy character trie. This proccess is
+ * timed. If alphabet is not NULL, patterns must be transcoded to its symbols
+ * and words are transcoded the same way, packed trie and Judy character trie
+ * are then not used and can be NULL. With incremental flag words are also
+ * hyphenated with Judy incrementally, reusing matches of the previous word.
  */
 void compare(const char *file_name, Pvoid_t *judy_array,
-             cp_trie *cprops_patricia_trie);
+             cp_trie *cprops_patricia_trie, Packed_trie *packed_trie,
+             Judy_trie *judy_trie, Alphabet *alphabet);
 
 #endif // !COMPARE_H
\ No newline at end of file
@@ -1,7 +1,12 @@
 #ifndef COMPARE_H
 #define COMPARE_H
 
+#include "alphabet.h"
+#include "packed.h"
+#include "judytrie.h"
+
 #include <Judy.h>
+#include <cprops/trie.h>
 #include <stdbool.h>
 
 /**
@@ -9,10 +14,24 @@
  */
 bool command_parser(const char *word, int read);
 
+/**
+ * Change hyphenation values of calling thread by command without any output.
+ * Returns true if hyphenation should end.
+ */
+bool command_apply(const char *word, int read);
+
+// Print message about values changed by command
+void command_report(const char *word, int read);
+
 /**
  * Hyphenate words from file or command line with patterns stored in Judy and
- * output them to the stdout
+ * output them to the stdout. If packed is not NULL, patterns from replica of
+ * packed trie local to the running thread are used instead of Judy, if
+ * judy_trie is not NULL, Judy character trie is used and if trie is not NULL,
+ * cprops trie is used. If alphabet is not NULL, patterns in Judy must be
+ * transcoded to its symbols.
  */
-void hyphenator(const char *file_name, Pvoid_t *pattern_judy);
+void hyphenator(const char *file_name, Pvoid_t *pattern_judy, Packed_set *packed,
+                Judy_trie *judy_trie, cp_trie *trie, Alphabet *alphabet);
 
 #endif // !COMPARE_H
\ No newline at end of file
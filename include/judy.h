@@ -4,16 +4,101 @@
 #include <Judy.h>
 #include "patterns.h"
 
+// Longer words with dots are not hyphenated incrementally, character offsets are in char
+#define JUDY_MAXWORDBYTES 127
+
+// Pattern found in word, its code is merged at position
+typedef struct
+{
+    const char *code;
+    int position;
+    int len;
+} Judy_match;
+
+/**
+ * State of incremental hyphenation kept between consecutive words. Word is
+ * copy of the previous word and matches are all patterns found in it. Zeroed
+ * state is valid empty state, reused_count and match_total are counted for
+ * all words together.
+ */
+typedef struct
+{
+    char *word;
+    int word_allocated;
+    Judy_match *matches;
+    int match_count;
+    int match_allocated;
+    long reused_count;
+    long match_total;
+} Judy_incremental;
+
 /**
  * Insert all patterns stored in patterns variable into judy data structure. 
  * This function is timed for comparison(outputted only with -v option).
  */
 void judy_insert_patterns(Pattern_wrapper *patterns, Pvoid_t *judy_array);
 
+/**
+ * Merge codes of all patterns from judy found in word with len characters into
+ * hyph_code, which must be zeroed and have HYPH_CODE_SIZE(len) bytes. Nothing
+ * is allocated. Returns the number of lookups.
+ */
+int judy_code(char *word, int len, Pvoid_t *judy_array, const char *utf8_code,
+              char *hyph_code);
+
+// Same as judy_code, but for word transcoded to len symbols of alphabet
+void judy_code_symbols(const unsigned char *symbols, int len, Pvoid_t *judy_array,
+                       char *hyph_code);
+
 /**
  * Hyphenate word using patterns stored in judy. Returns pointer to allocated
  * string with hyphenation characters.
  */
 char *judy_hyphenate(char *word, Pvoid_t *judy_array, const char *utf8_code);
 
+/**
+ * Merge codes of patterns found in count keys into hyph_codes, same as
+ * judy_code, but lookups of all keys are interleaved like in
+ * judy_hyphenate_batch. Key w has lens[w] characters with byte offsets in
+ * utf8_codes[w] and hyph_codes[w] must be zeroed HYPH_CODE_SIZE(lens[w]) bytes.
+ * Nothing is allocated.
+ */
+void judy_code_batch(char **keys, char **utf8_codes, const int *lens, int count,
+                     Pvoid_t *judy_array, char **hyph_codes);
+
+/**
+ * Hyphenate count words using patterns stored in judy. Lookups of all words are
+ * interleaved, one substring of every word at a time, and pattern codes of hits
+ * are prefetched and merged only in the next round. Every JSLF still walks
+ * Judy to the end, so only misses of pattern codes and of separate lookups can
+ * overlap, packed_hyphenate_batch interleaves single nodes. Every results[i] is
+ * allocated string with hyphenation characters, same as from judy_hyphenate.
+ * If allocation failed, every results[i] is NULL.
+ */
+void judy_hyphenate_batch(char **words, char **utf8_codes, int count,
+                          Pvoid_t *judy_array, char **results);
+
+/**
+ * Hyphenate word using patterns transcoded to alphabet symbols and stored in
+ * judy. Symbols must be the transcoded word with len symbols, so every
+ * character is exactly 1 byte and no utf8 offsets are needed. Returns pointer
+ * to allocated string with hyphenation characters.
+ */
+char *judy_hyphenate_symbols(char *word, unsigned char *symbols, int len,
+                             Pvoid_t *judy_array);
+
+/**
+ * Hyphenate word using patterns stored in judy, same as judy_hyphenate, but
+ * matches of the previous word from state which lie entirely inside of prefix
+ * shared with word are reused. Only substrings reaching behind the shared
+ * prefix are searched, so sorted words are hyphenated faster. Words longer
+ * than JUDY_MAXWORDBYTES are hyphenated by judy_hyphenate and state is kept.
+ * Returns pointer to allocated string with hyphenation characters.
+ */
+char *judy_hyphenate_incremental(char *word, Pvoid_t *judy_array, const char *utf8_code,
+                                 Judy_incremental *state);
+
+// Free memory of incremental state and zero it
+void judy_incremental_free(Judy_incremental *state);
+
 #endif // !JUDY_H
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef JUDYTRIE_H
+#define JUDYTRIE_H
+
+#include <Judy.h>
+#include "patterns.h"
+
+// Bits of JudyL index used for code point, node id is stored above them
+#define JUDY_TRIE_CHAR_BITS 21
+
+/**
+ * Character trie stored in one JudyL array. Edge from node n by character c
+ * is index (n << JUDY_TRIE_CHAR_BITS) | c with id of the child as value and
+ * index n << JUDY_TRIE_CHAR_BITS (character 0) holds pattern code of node n.
+ * Root has id 0, so no pattern is empty.
+ * Ex.: patterns a1b and 2ac give edges (0, a) -> 1, (1, b) -> 2, (1, c) -> 3
+ */
+typedef struct
+{
+    Pvoid_t array;
+    Word_t node_count;
+} Judy_trie;
+
+/**
+ * Insert all patterns stored in patterns variable into Judy character trie.
+ * This function is timed for comparison(outputted only with -v option).
+ */
+void judy_trie_insert_patterns(Pattern_wrapper *patterns, Judy_trie *trie);
+
+/**
+ * Hyphenate word using patterns stored in Judy character trie. Trie is
+ * descended one character at a time from every character of word, so every
+ * substring is not searched from the root. Returns pointer to allocated
+ * string with hyphenation characters.
+ */
+char *judy_trie_hyphenate(char *word, Judy_trie *trie, const char *utf8_code);
+
+// Free JudyL array of trie, returns count of freed bytes
+Word_t judy_trie_free(Judy_trie *trie);
+
+#endif // !JUDYTRIE_H
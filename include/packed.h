@@ -0,0 +1,157 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#include "patterns.h"
+#include "topology.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Size of huge page used for rounding of mapped memory
+#define PACKED_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// How memory of packed trie was obtained
+#define PACKED_PAGES_DEFAULT 0
+#define PACKED_PAGES_HUGETLB 1
+#define PACKED_PAGES_THP 2
+
+// Size of cache line used for counting lines touched by hot nodes
+#define PACKED_CACHE_LINE 64
+
+// Share of all hits which hot nodes counted by packed_hot_lines have together
+#define PACKED_HOT_SHARE 0.9
+
+// Smaller tries stay in cache, so hyphenator does not interleave their descents
+#define PACKED_BATCH_MIN_SIZE (32 * 1024 * 1024)
+
+/**
+ * Node of packed trie. Children of every node have consecutive indexes
+ * starting at first_child, so no edges are stored. Code is offset of pattern
+ * code in codes of trie or 0 if no pattern ends in this node.
+ */
+typedef struct
+{
+    uint32_t first_child;
+    uint32_t code;
+    uint16_t child_count;
+} Packed_node;
+
+/**
+ * Read-only trie of patterns compiled into one block of memory. Block holds
+ * nodes, labels (byte leading to every node, indexed by node) and codes padded
+ * to CODE_PADDED_SIZE. Only indexes and offsets are stored inside the block,
+ * so it can be copied.
+ * Ex.: patterns a1b and 2ac give nodes root, a, b, c with labels [0, a, b, c]
+ */
+typedef struct
+{
+    char *memory;
+    size_t size;
+    size_t mapped_size;
+    int page_mode;
+    uint32_t node_count;
+    uint32_t code_size;
+    const Packed_node *nodes;
+    const unsigned char *labels;
+    const char *codes;
+} Packed_trie;
+
+/**
+ * Packed tries for all NUMA nodes. With replication every node has its own
+ * copy of trie in local memory, otherwise there is only one trie.
+ */
+typedef struct
+{
+    Packed_trie replicas[TOPOLOGY_MAX_NODES];
+    int replica_count;
+    Topology topology;
+} Packed_set;
+
+/**
+ * Compile all patterns into packed trie. With huge_pages the block is mapped
+ * with MAP_HUGETLB, then with transparent huge pages and at last allocated
+ * with malloc. This function is timed for comparison(outputted only with -v).
+ * Returns 0 if everything went ok, returns 1 if allocation failed.
+ */
+int packed_build(Pattern_wrapper *patterns, Packed_trie *trie, bool huge_pages);
+
+/**
+ * Copy block of source trie into new memory of destination trie. Pages are
+ * touched by the calling thread, so they are placed on its NUMA node. Returns
+ * 0 if everything went ok, returns 1 if allocation failed.
+ */
+int packed_copy(Packed_trie *destination, const Packed_trie *source, bool huge_pages);
+
+// Free memory block of trie
+void packed_free(Packed_trie *trie);
+
+/**
+ * Hyphenate word using patterns stored in packed trie. Trie is descended one
+ * byte at a time from every character of word, so every substring is not
+ * searched from the root. Returns pointer to allocated string with hyphenation
+ * characters.
+ */
+char *packed_hyphenate(char *word, const Packed_trie *trie, const char *utf8_code);
+
+/**
+ * Merge codes of patterns found in count keys into hyph_codes, same as
+ * packed_hyphenate does. Descents of all keys are interleaved, in every round
+ * each key reads its reached node, searches labels of its children and
+ * prefetches the found child, which is read in the next round, so cache
+ * misses of different keys overlap. It pays off only for tries much bigger
+ * than the last level cache. Key w has lens[w] characters with byte offsets in
+ * utf8_codes[w] and hyph_codes[w] must be zeroed HYPH_CODE_SIZE(lens[w])
+ * bytes. Nothing is allocated.
+ */
+void packed_code_batch(char **keys, char **utf8_codes, const int *lens, int count,
+                       const Packed_trie *trie, char **hyph_codes);
+
+/**
+ * Hyphenate count words using packed trie with packed_code_batch. Every
+ * results[i] is allocated string with hyphenation characters, same as from
+ * packed_hyphenate. If allocation failed, every results[i] is NULL.
+ */
+void packed_hyphenate_batch(char **words, char **utf8_codes, int count, const Packed_trie *trie,
+                            char **results);
+
+/**
+ * Replay words from file_name on trie the same way packed_hyphenate descends
+ * it and count how many times every node was reached. Hits must have
+ * node_count zeroed items. Returns the number of replayed words or -1 if file
+ * was not opened correctly.
+ */
+int packed_profile(const Packed_trie *trie, const char *file_name, uint32_t *hits);
+
+/**
+ * Copy source trie into trie with layout guided by hits of source nodes.
+ * Groups of siblings are ordered by the sum of their hits, so hot nodes are
+ * together at the start of the block, siblings are ordered by their own hits,
+ * so the hot child is found first, and codes of hot nodes are placed first.
+ * Hyphenation with both tries is the same. Returns 0 if everything went ok,
+ * returns 1 if allocation failed.
+ */
+int packed_relayout(const Packed_trie *source, const uint32_t *hits, Packed_trie *trie,
+                    bool huge_pages);
+
+/**
+ * Count PACKED_CACHE_LINE byte lines of block holding node, label or the first
+ * vector of code of the hottest nodes, which have PACKED_HOT_SHARE of all hits.
+ */
+uint32_t packed_hot_lines(const Packed_trie *trie, const uint32_t *hits);
+
+/**
+ * Compile patterns and with numa create one replica for every NUMA node found
+ * in /sys. On machines with 1 node only one trie is created. Returns 0 if
+ * everything went ok, returns 1 if allocation failed.
+ */
+int packed_set_create(Packed_set *set, Pattern_wrapper *patterns, bool huge_pages,
+                      bool numa);
+
+// Returns replica of trie for NUMA node of calling thread
+const Packed_trie *packed_local(Packed_set *set);
+
+// Free all replicas
+void packed_set_free(Packed_set *set);
+
+#endif // !PACKED_H
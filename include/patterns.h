@@ -33,6 +33,13 @@ void patterns_show(Pattern_wrapper *patterns, int index);
  */
 int patterns_load(Pattern_wrapper *patterns, const char *file_name);
 
+/**
+ * Write patterns in the same format as the .pat files in assets, so they can
+ * be loaded again with patterns_load. Returns 0 if everything went ok, returns
+ * 1 if file was not opened correctly.
+ */
+int patterns_save(Pattern_wrapper *patterns, const char *file_name);
+
 // Functions for freeing all patterns and freeing pattern wrapper
 void patterns_free(Pattern_wrapper *patterns);
 
@@ -0,0 +1,49 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdbool.h>
+
+// Count of batches which fit into one ring between stages
+#define PIPELINE_RING_SIZE 8
+
+// Size of chunks read from input
+#define PIPELINE_CHUNK_SIZE 65536
+
+/**
+ * Function which hyphenates one line of input with read bytes and returns
+ * allocated result. It is called from worker threads at the same time, so it
+ * can only read shared data structures.
+ */
+typedef char *(*Pipeline_hyphenate)(char *line, int read, void *context);
+
+/**
+ * Batch of input lines passed between stages. Command batch holds only one
+ * command line and no results. Values of left_hyphen_min and right_hyphen_min
+ * are taken by reader when the batch is started.
+ */
+typedef struct
+{
+    long sequence;
+    bool command;
+    int left_hyphen_min;
+    int right_hyphen_min;
+    int count;
+    char *text;
+    int text_size;
+    int text_allocated;
+    int *offsets;
+    int *lengths;
+    char **results;
+} Pipeline_batch;
+
+/**
+ * Hyphenate lines from file descriptor fd in pipeline and output them to the
+ * stdout in the same order. Reader (calling thread) splits input into batches
+ * of at most batch_size lines, which are hyphenated by worker_count workers and
+ * printed by writer. Batch which is not full is passed on after max_latency
+ * milliseconds. Commands :q, :l and :r are applied in the order of input.
+ */
+void pipeline_run(int fd, Pipeline_hyphenate hyphenate, void *context, int worker_count,
+                  int batch_size, int max_latency);
+
+#endif // !PIPELINE_H
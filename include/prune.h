@@ -0,0 +1,39 @@
+#ifndef PRUNE_H
+#define PRUNE_H
+
+#include <Judy.h>
+#include "patterns.h"
+
+// Words with dots longer than this are skipped, character offsets are in char
+#define PRUNE_MAXWORDBYTES 127
+
+// Counts of patterns removed by prune_patterns
+typedef struct
+{
+    int duplicate_count;
+    int dominated_count;
+} Prune_stats;
+
+/**
+ * Copy all patterns which can change result of hyphenation from patterns to
+ * pruned, in the same order. Pattern is removed if it is a duplicate (the last
+ * one is used, same as in Judy) or if it is dominated: every non zero value of
+ * its code is lower or equal to the value at the same position of some
+ * pattern, which is a shorter substring of it. Such pattern matches everywhere
+ * the dominated one does, so merged code of every word stays the same.
+ * Ex.: pattern a1b2c is dominated by patterns a1b and b2c, pattern a1b2c is
+ * not dominated by a1b and bc.
+ * Returns 0 if everything went ok, returns 1 if allocation failed.
+ */
+int prune_patterns(Pattern_wrapper *patterns, Pattern_wrapper *pruned, Prune_stats *stats);
+
+/**
+ * Hyphenate every word from file_name with patterns from original_judy and
+ * pruned_judy and compare the results. Time of both hyphenations is added to
+ * time_original and time_pruned. Returns the number of different words or -1
+ * if file was not opened correctly.
+ */
+int prune_verify(const char *file_name, Pvoid_t *original_judy, Pvoid_t *pruned_judy,
+                 double *time_original, double *time_pruned);
+
+#endif // !PRUNE_H
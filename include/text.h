@@ -0,0 +1,32 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include "alphabet.h"
+
+#include <Judy.h>
+#include <stdbool.h>
+
+// Size of buffers for input and output of running text
+#define TEXT_BUFFER_SIZE (1024 * 1024)
+
+// Longest word in characters which is hyphenated, longer words are copied
+#define TEXT_MAXWORD 64
+
+// Utf8 encoding of U+00AD soft hyphen
+#define TEXT_SOFT_HYPHEN "\xC2\xAD"
+
+/**
+ * Hyphenate running utf8 text read from file descriptor fd and write it to
+ * the stdout with hyphens inserted into words. Words are the longest runs of
+ * letters (ASCII letters, non ASCII letters of the locale and characters of
+ * alphabet), everything else is copied unchanged. Words are folded to lower
+ * case for lookup, but written as they were. If alphabet is not NULL, patterns
+ * in Judy must be transcoded to its symbols. With soft_hyphen U+00AD is
+ * inserted instead of hyphenation character. Words of every block are
+ * hyphenated in batches of batch_size with interleaved Judy lookups and
+ * nothing is allocated per word.
+ * Returns 0 if everything went ok, returns 1 if allocation or reading failed.
+ */
+int text_hyphenate(int fd, Pvoid_t *pattern_judy, Alphabet *alphabet, bool soft_hyphen);
+
+#endif // !TEXT_H
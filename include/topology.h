@@ -0,0 +1,39 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+// cpu_set_t needs _GNU_SOURCE defined before any include
+#include <sched.h>
+
+// Limits of NUMA nodes and cpus read from /sys
+#define TOPOLOGY_MAX_NODES 64
+#define TOPOLOGY_MAX_CPUS CPU_SETSIZE
+
+/**
+ * NUMA nodes of machine and their cpus. Nodes are indexed from 0 to
+ * node_count - 1 and every cpu has index of its node in cpu_node.
+ * Ex.: 2 nodes with cpus 0-3 and 4-7 give cpu_node = [0, 0, 0, 0, 1, 1, 1, 1]
+ */
+typedef struct
+{
+    int node_count;
+    int node_ids[TOPOLOGY_MAX_NODES];
+    cpu_set_t cpus[TOPOLOGY_MAX_NODES];
+    int cpu_node[TOPOLOGY_MAX_CPUS];
+} Topology;
+
+/**
+ * Load NUMA nodes from /sys/devices/system/node. If nodes can not be read,
+ * whole machine is loaded as 1 node. Returns count of nodes.
+ */
+int topology_load(Topology *topology);
+
+// Returns index of node on which the calling thread runs right now
+int topology_local_node(const Topology *topology);
+
+/**
+ * Allow calling thread to run only on cpus of node with index node. Returns 0
+ * if everything went ok, returns 1 if affinity could not be set.
+ */
+int topology_bind(const Topology *topology, int node);
+
+#endif // !TOPOLOGY_H
@@ -17,4 +17,12 @@ void trie_insert_patterns(Pattern_wrapper *patterns, cp_trie *patricia_trie);
  */
 char *trie_hyphenate(char *word, cp_trie *cprops_patricia_trie, const char *utf8_code);
 
+/**
+ * Hyphenate word using patterns transcoded to alphabet symbols and stored in
+ * Cprops Trie. Symbols must be the transcoded word with len symbols. Returns
+ * pointer to allocated string with hyphenation characters.
+ */
+char *trie_hyphenate_symbols(char *word, unsigned char *symbols, int len,
+                             cp_trie *cprops_patricia_trie);
+
 #endif // !TRIE_H
\ No newline at end of file
@@ -4,6 +4,11 @@
 #include <sys/time.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 // Timing routines
 extern struct timeval TBeg;
@@ -14,6 +19,20 @@ extern struct timeval TEnd;
 #define DeltaUSec (((double)TEnd.tv_sec * 1000000.0 + (double)TEnd.tv_usec) - \
                    ((double)TBeg.tv_sec * 1000000.0 + (double)TBeg.tv_usec))
 
+/**
+ * Pattern codes and hyphenation codes are padded with zeros to whole vectors
+ * of CODE_VECTOR_SIZE bytes, so they can be merged without checking length.
+ * Code of pattern with len characters has CODE_PADDED_SIZE(len) bytes,
+ * hyphenation code of word with len characters must have HYPH_CODE_SIZE(len)
+ * bytes, because padded code of the last pattern can end behind the word.
+ */
+#define CODE_VECTOR_SIZE 16
+#define CODE_PADDED_SIZE(len) (((len) + CODE_VECTOR_SIZE) & ~(CODE_VECTOR_SIZE - 1))
+#define HYPH_CODE_SIZE(len) (CODE_PADDED_SIZE(len) + CODE_VECTOR_SIZE)
+
+// Count of 64 bit words of bitmask with breaks of word with len characters
+#define CODE_BREAK_WORDS(len) ((CODE_PADDED_SIZE(len) + 63) / 64)
+
 /**
  * Add one dot before and one after word. Input must be pointer to allocated
  * memory on heap.
@@ -25,6 +44,18 @@ char *add_dots_to_word(int len, char *word);
  */
 int strlen_utf8(const char *str);
 
+/**
+ * Decode one utf8 character at the beginning of str into code_point. Returns
+ * the number of bytes of the character, but never reads behind the end of str.
+ */
+int utf8_decode(const char *str, int *code_point);
+
+/**
+ * Encode code_point as utf8 into buffer, which must have space for 4 bytes.
+ * Returns the number of written bytes.
+ */
+int utf8_encode(int code_point, char *buffer);
+
 /**
  * Create an array that contains the sum of the byte length of all characters
  * before each position. For the string "abcábč" the resulting array look like
@@ -32,10 +63,68 @@ int strlen_utf8(const char *str);
  */
 char *create_utf_array(char *word);
 
+// Merge padded code of pattern with len characters into hyph_code byte by byte
+static inline void code_merge_scalar(char *hyph_code, const char *pattern_code, int len)
+{
+    for (int k = 0; k <= len; k++)
+        if (pattern_code[k] > hyph_code[k])
+            hyph_code[k] = pattern_code[k];
+}
+
+/**
+ * Merge padded code of pattern with len characters into hyph_code, every
+ * value is the maximum of both. With SSE2 one vector max is used for every
+ * CODE_VECTOR_SIZE values, otherwise code_merge_scalar.
+ */
+static inline void code_merge(char *hyph_code, const char *pattern_code, int len)
+{
+#ifdef __SSE2__
+    for (int k = 0; k < CODE_PADDED_SIZE(len); k += CODE_VECTOR_SIZE)
+    {
+        __m128i merged = _mm_max_epu8(_mm_loadu_si128((const __m128i *)&hyph_code[k]),
+                                      _mm_loadu_si128((const __m128i *)&pattern_code[k]));
+        _mm_storeu_si128((__m128i *)&hyph_code[k], merged);
+    }
+#else
+    code_merge_scalar(hyph_code, pattern_code, len);
+#endif
+}
+
+/**
+ * Fill bitmask breaks of CODE_BREAK_WORDS(len_utf) words with positions of
+ * odd values in padded hyphenation code of word with len_utf characters.
+ * Positions closer to the ends than left_hyphen_min and right_hyphen_min are
+ * masked out. With SSE2 parity of CODE_VECTOR_SIZE values is extracted at
+ * once. Returns the number of breaks.
+ */
+int code_breaks(const char *code, int len_utf, uint64_t *breaks);
+
+// Same as code_breaks, but every value is tested separately
+int code_breaks_scalar(const char *code, int len_utf, uint64_t *breaks);
+
 /**
  * This functions takes a word and full hyphenation code and returns an
- * allocated hyphenated word.
+ * allocated hyphenated word. Code must be padded to HYPH_CODE_SIZE bytes.
  */
 char *hyphenate_from_code(char *word, char *code);
 
+/**
+ * Returns the number of bytes currently allocated on the heap by malloc. Used
+ * for measuring memory of data structures from inside of the program.
+ */
+size_t heap_usage(void);
+
+/**
+ * Start counting hardware cache misses of the calling thread with
+ * perf_event_open. Returns file descriptor of the counter or -1 if counters
+ * are not available, for example in containers or with perf_event_paranoid.
+ */
+int cache_misses_start(void);
+
+/**
+ * Stop counter from cache_misses_start and close it. Returns the number of
+ * cache misses or -1 if fd is -1 or counter could not be read.
+ */
+long long cache_misses_stop(int fd);
+
 #endif // !UTILS_H
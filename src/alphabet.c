@@ -0,0 +1,118 @@
+#include "alphabet.h"
+#include "patterns.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+
+extern bool verbose;
+
+unsigned char alphabet_symbol(Alphabet *alphabet, int code_point)
+{
+    if (code_point < 128)
+        return alphabet->ascii[code_point];
+
+    if (code_point >= 0x110000)
+        return ALPHABET_UNKNOWN;
+
+    unsigned char *page = alphabet->pages[code_point / ALPHABET_PAGE_SIZE];
+    if (page == NULL)
+        return ALPHABET_UNKNOWN;
+
+    return page[code_point % ALPHABET_PAGE_SIZE];
+}
+
+// Private alphabet.c function which gives code point next free symbol
+static int alphabet_add(Alphabet *alphabet, int code_point)
+{
+    if (code_point >= 0x110000 || alphabet_symbol(alphabet, code_point) != ALPHABET_UNKNOWN)
+        return 0;
+
+    if (alphabet->size == ALPHABET_MAX_SIZE)
+    {
+        printf("Patterns use more than %i characters\n", ALPHABET_MAX_SIZE);
+        return 1;
+    }
+
+    if (code_point < 128)
+    {
+        alphabet->ascii[code_point] = ++alphabet->size;
+        return 0;
+    }
+
+    unsigned char **page = &alphabet->pages[code_point / ALPHABET_PAGE_SIZE];
+    if (*page == NULL)
+    {
+        *page = malloc(ALPHABET_PAGE_SIZE);
+        if (*page == NULL)
+        {
+            printf("Allocation error\n");
+            return 1;
+        }
+        memset(*page, ALPHABET_UNKNOWN, ALPHABET_PAGE_SIZE);
+    }
+
+    (*page)[code_point % ALPHABET_PAGE_SIZE] = ++alphabet->size;
+    return 0;
+}
+
+int alphabet_create(Alphabet *alphabet, Pattern_wrapper *patterns)
+{
+    int code_point;
+
+    memset(alphabet->ascii, ALPHABET_UNKNOWN, sizeof(alphabet->ascii));
+    memset(alphabet->pages, 0, sizeof(alphabet->pages));
+    alphabet->size = 0;
+
+    for (int i = 0; i < patterns->count; i++)
+    {
+        const char *word = patterns->patterns[i].word;
+        while (*word)
+        {
+            word += utf8_decode(word, &code_point);
+            if (alphabet_add(alphabet, code_point))
+                return 1;
+        }
+    }
+
+    if (verbose)
+        printf("Alphabet of %i patterns has %i characters\n", patterns->count, alphabet->size);
+
+    return 0;
+}
+
+int alphabet_transcode(Alphabet *alphabet, const char *word, unsigned char *symbols)
+{
+    int code_point;
+    int len = 0;
+
+    while (*word)
+    {
+        if ((unsigned char)*word < 128)
+        {
+            symbols[len++] = alphabet->ascii[(unsigned char)*word];
+            word++;
+            continue;
+        }
+
+        word += utf8_decode(word, &code_point);
+        symbols[len++] = alphabet_symbol(alphabet, code_point);
+    }
+
+    symbols[len] = '\0';
+    return len;
+}
+
+void alphabet_transcode_patterns(Alphabet *alphabet, Pattern_wrapper *patterns)
+{
+    // Symbols are never longer than utf8 word, so they are written in place
+    for (int i = 0; i < patterns->count; i++)
+        alphabet_transcode(alphabet, patterns->patterns[i].word,
+                           (unsigned char *)patterns->patterns[i].word);
+}
+
+void alphabet_free(Alphabet *alphabet)
+{
+    for (int i = 0; i < ALPHABET_PAGE_COUNT; i++)
+        free(alphabet->pages[i]);
+}
@@ -0,0 +1,340 @@
+#define _GNU_SOURCE
+
+#include "backend.h"
+#include "patterns.h"
+#include "judy.h"
+#include "judytrie.h"
+#include "trie.h"
+#include "packed.h"
+#include "utils.h"
+
+#include <Judy.h>
+#include <cprops/trie.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern bool verbose;
+
+static void *backend_judy_create(Pattern_wrapper *patterns)
+{
+    Pvoid_t *pattern_judy = calloc(1, sizeof(Pvoid_t));
+    judy_insert_patterns(patterns, pattern_judy);
+    return pattern_judy;
+}
+
+static char *backend_judy_hyphenate(char *word, void *structure, const char *utf8_code)
+{
+    return judy_hyphenate(word, structure, utf8_code);
+}
+
+static void backend_judy_destroy(void *structure)
+{
+    Word_t freed_count;
+    JSLFA(freed_count, *(Pvoid_t *)structure);
+    free(structure);
+}
+
+static void *backend_trie_create(Pattern_wrapper *patterns)
+{
+    cp_trie *pattern_trie = cp_trie_create(COLLECTION_MODE_NOSYNC);
+    trie_insert_patterns(patterns, pattern_trie);
+    return pattern_trie;
+}
+
+static char *backend_trie_hyphenate(char *word, void *structure, const char *utf8_code)
+{
+    return trie_hyphenate(word, structure, utf8_code);
+}
+
+static void backend_trie_destroy(void *structure)
+{
+    cp_trie_destroy(structure);
+}
+
+static void *backend_packed_create(Pattern_wrapper *patterns)
+{
+    Packed_trie *pattern_packed = malloc(sizeof(Packed_trie));
+    if (pattern_packed && packed_build(patterns, pattern_packed, false))
+    {
+        free(pattern_packed);
+        return NULL;
+    }
+    return pattern_packed;
+}
+
+static char *backend_packed_hyphenate(char *word, void *structure, const char *utf8_code)
+{
+    return packed_hyphenate(word, structure, utf8_code);
+}
+
+static void backend_packed_destroy(void *structure)
+{
+    packed_free(structure);
+    free(structure);
+}
+
+static void *backend_judy_trie_create(Pattern_wrapper *patterns)
+{
+    Judy_trie *pattern_judy_trie = calloc(1, sizeof(Judy_trie));
+    judy_trie_insert_patterns(patterns, pattern_judy_trie);
+    return pattern_judy_trie;
+}
+
+static char *backend_judy_trie_hyphenate(char *word, void *structure, const char *utf8_code)
+{
+    return judy_trie_hyphenate(word, structure, utf8_code);
+}
+
+static void backend_judy_trie_destroy(void *structure)
+{
+    judy_trie_free(structure);
+    free(structure);
+}
+
+const Backend backends[BACKEND_COUNT] = {
+    [BACKEND_JUDY] = {"judy", backend_judy_create, backend_judy_hyphenate, backend_judy_destroy},
+    [BACKEND_TRIE] = {"trie", backend_trie_create, backend_trie_hyphenate, backend_trie_destroy},
+    [BACKEND_PACKED] = {"packed", backend_packed_create, backend_packed_hyphenate,
+                        backend_packed_destroy},
+    [BACKEND_JUDY_TRIE] = {"judytrie", backend_judy_trie_create, backend_judy_trie_hyphenate,
+                           backend_judy_trie_destroy},
+};
+
+/**
+ * Private backend.c function which loads up to BACKEND_SAMPLE_COUNT sample
+ * words spread over file_name with the same distance into words, so sorted
+ * file gives words of all prefixes. Returns the number of loaded words or -1
+ * if file was not opened.
+ */
+static int backend_sample_file(const char *file_name, char **words)
+{
+    FILE *fp = fopen(file_name, "r");
+    if (fp == NULL)
+        return -1;
+
+    char *line = NULL;
+    size_t len = 0;
+    ssize_t read;
+    long line_count = 0;
+    int count = 0;
+
+    // The first pass counts usable words, the second one takes every stride-th
+    for (int pass = 0; pass < 2; pass++)
+    {
+        long stride = line_count > BACKEND_SAMPLE_COUNT ? line_count / BACKEND_SAMPLE_COUNT : 1;
+        long index = 0;
+
+        while (count < BACKEND_SAMPLE_COUNT && (read = getline(&line, &len, fp)) != -1)
+        {
+            // Remove new line character
+            if (read > 0 && line[read - 1] == '\n')
+                line[--read] = '\0';
+
+            // Skip if no word was loaded or if it is too long
+            if (read == 0 || read + 2 > BACKEND_MAXWORDBYTES || line[0] == ':')
+                continue;
+
+            if (pass == 0)
+                line_count++;
+            else if (index++ % stride == 0)
+                words[count++] = strdup(line);
+        }
+
+        rewind(fp);
+    }
+
+    fclose(fp);
+    free(line);
+
+    return count;
+}
+
+/**
+ * Private backend.c function which builds backend from BACKEND_ESTIMATE_COUNT
+ * patterns spread over patterns and returns its footprint extrapolated to all
+ * patterns. Shared prefixes are rarer in the subset, so tries are rather
+ * overestimated. Returns 0 if patterns are not more than the subset.
+ */
+static size_t backend_estimate(const Backend *backend, Pattern_wrapper *patterns)
+{
+    if (patterns->count <= BACKEND_ESTIMATE_COUNT)
+        return 0;
+
+    // Subset only points to patterns, so it is freed without patterns_free
+    Pattern_wrapper subset = {malloc(BACKEND_ESTIMATE_COUNT * sizeof(Pattern)),
+                              BACKEND_ESTIMATE_COUNT};
+    if (subset.patterns == NULL)
+        return 0;
+
+    for (int i = 0; i < BACKEND_ESTIMATE_COUNT; i++)
+        subset.patterns[i] = patterns->patterns[(long)i * patterns->count / BACKEND_ESTIMATE_COUNT];
+
+    size_t heap_before = heap_usage();
+    void *structure = backend->create(&subset);
+    size_t heap_after = heap_usage();
+
+    size_t estimate = 0;
+    if (structure)
+    {
+        if (heap_after > heap_before)
+            estimate = (double)(heap_after - heap_before) * patterns->count / BACKEND_ESTIMATE_COUNT;
+        backend->destroy(structure);
+    }
+    free(subset.patterns);
+
+    return estimate;
+}
+
+/**
+ * Private backend.c function which makes sample words by joining letters of
+ * two patterns from distant parts of patterns. Returns the number of words.
+ */
+static int backend_sample_patterns(Pattern_wrapper *patterns, char **words)
+{
+    int count = patterns->count < BACKEND_SAMPLE_COUNT ? patterns->count : BACKEND_SAMPLE_COUNT;
+
+    for (int i = 0; i < count; i++)
+    {
+        const char *parts[2] = {patterns->patterns[(long)i * patterns->count / count].word,
+                                patterns->patterns[((long)i * 7919 + patterns->count / 2) %
+                                                   patterns->count].word};
+        char buffer[BACKEND_MAXWORDBYTES];
+        int index = 0;
+
+        for (int p = 0; p < 2; p++)
+            for (const char *c = parts[p]; *c && index < BACKEND_MAXWORDBYTES / 2 - 4; c++)
+                if (*c != '.')
+                    buffer[index++] = *c;
+
+        // Last character could have been split
+        while (index > 0 && (buffer[index - 1] & 0xC0) == 0x80)
+            index--;
+        if (index > 0 && (unsigned char)buffer[index - 1] >= 0xC0)
+            index--;
+        buffer[index] = '\0';
+
+        words[i] = strdup(index > 0 ? buffer : "a");
+    }
+
+    return count;
+}
+
+int backend_select(Pattern_wrapper *patterns, const char *file_name, size_t max_bytes,
+                   double max_usec, Backend_measure measures[BACKEND_COUNT])
+{
+    for (int b = 0; b < BACKEND_COUNT; b++)
+        measures[b] = (Backend_measure){0, 0, 0, false};
+
+    // Backends far over memory budget are not built at all, if none fits, the smallest one is
+    int smallest = -1;
+    bool any_fits = max_bytes == 0;
+    if (max_bytes)
+        for (int b = 0; b < BACKEND_COUNT; b++)
+        {
+            measures[b].estimate = backend_estimate(&backends[b], patterns);
+            if (measures[b].estimate <= max_bytes)
+                any_fits = true;
+            if (smallest == -1 || measures[b].estimate < measures[smallest].estimate)
+                smallest = b;
+        }
+
+    char **words = calloc(BACKEND_SAMPLE_COUNT, sizeof(char *));
+    char **utf8_codes = calloc(BACKEND_SAMPLE_COUNT, sizeof(char *));
+    if (words == NULL || utf8_codes == NULL)
+    {
+        printf("Allocation error\n");
+        free(words);
+        free(utf8_codes);
+        return -1;
+    }
+
+    int word_count = file_name ? backend_sample_file(file_name, words) : -1;
+    if (word_count <= 0)
+        word_count = backend_sample_patterns(patterns, words);
+
+    // Words are prepared outside of measured time
+    for (int i = 0; i < word_count; i++)
+    {
+        char *dotted = add_dots_to_word(strlen(words[i]), words[i]);
+        free(words[i]);
+        words[i] = dotted;
+        utf8_codes[i] = create_utf_array(words[i]);
+    }
+
+    // Output of lookups would be measured too
+    bool verbose_backup = verbose;
+    verbose = false;
+
+    for (int b = 0; b < BACKEND_COUNT; b++)
+    {
+        if (max_bytes && measures[b].estimate > max_bytes && (any_fits || b != smallest))
+        {
+            if (verbose_backup)
+                printf("Backend %s is estimated to %zu bytes and is not built\n",
+                       backends[b].name, measures[b].estimate);
+            continue;
+        }
+
+        size_t heap_before = heap_usage();
+        void *structure = backends[b].create(patterns);
+        size_t heap_after = heap_usage();
+        if (structure == NULL)
+            continue;
+
+        measures[b].bytes = heap_after > heap_before ? heap_after - heap_before : 0;
+
+        // Untimed pass faults in pages of structure and sample, so no backend pays for it
+        for (int i = 0; i < word_count; i++)
+            free(backends[b].hyphenate(words[i], structure, utf8_codes[i]));
+
+        STARTTm;
+        for (int i = 0; i < word_count; i++)
+            free(backends[b].hyphenate(words[i], structure, utf8_codes[i]));
+        ENDTm;
+
+        measures[b].usec_per_word = word_count ? DeltaUSec / word_count : 0;
+        measures[b].measured = true;
+
+        backends[b].destroy(structure);
+    }
+
+    verbose = verbose_backup;
+
+    for (int i = 0; i < word_count; i++)
+    {
+        free(words[i]);
+        free(utf8_codes[i]);
+    }
+    free(words);
+    free(utf8_codes);
+
+    // The fastest within both limits, then the fastest within memory, then the smallest
+    int chosen = -1;
+    for (int pass = 0; pass < 3 && chosen == -1; pass++)
+        for (int b = 0; b < BACKEND_COUNT; b++)
+        {
+            if (!measures[b].measured)
+                continue;
+
+            bool fits_memory = max_bytes == 0 || measures[b].bytes <= max_bytes;
+            bool fits_time = max_usec <= 0 || measures[b].usec_per_word <= max_usec;
+
+            if ((pass == 0 && !(fits_memory && fits_time)) || (pass == 1 && !fits_memory))
+                continue;
+
+            if (chosen == -1 ||
+                (pass < 2 && measures[b].usec_per_word < measures[chosen].usec_per_word) ||
+                (pass == 2 && measures[b].bytes < measures[chosen].bytes))
+                chosen = b;
+        }
+
+    if (chosen != -1 && max_bytes && measures[chosen].bytes > max_bytes)
+        fprintf(stderr, "No backend fits into %zu bytes, the smallest one %s needs %zu bytes\n",
+                max_bytes, backends[chosen].name, measures[chosen].bytes);
+    else if (chosen != -1 && max_usec > 0 && measures[chosen].usec_per_word > max_usec)
+        fprintf(stderr, "No backend meets latency goal, the fastest one within memory %s needs "
+                "%.3f microseconds per word\n", backends[chosen].name, measures[chosen].usec_per_word);
+
+    return chosen;
+}
@@ -0,0 +1,664 @@
+#define _GNU_SOURCE
+
+#include "bench.h"
+#include "backend.h"
+#include "patterns.h"
+#include "judy.h"
+#include "utils.h"
+
+#include <Judy.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <assert.h>
+
+// Global constants
+__thread int left_hyphen_min = 2;
+__thread int right_hyphen_min = 2;
+bool verbose = false;
+char hyphenation_char = '-';
+char usage[] = "\nUsage: bench [options]\n"
+               "bench program generates synthetic patterns and words and measures how every backend scales\n\n"
+               "Options:\n"
+               "\t-h\t\tShow this message\n"
+               "\t-p list\t\tcomma separated pattern counts (default 1000,10000,100000,1000000)\n"
+               "\t-l list\t\tcomma separated word lengths in characters, x or min-max (default 4,8,16,32)\n"
+               "\t-d file\t\talso generate words with lengths distributed as in word file\n"
+               "\t-a list\t\tcomma separated UTF-8 bytes per character, 1 to 3 (default 1,2,3)\n"
+               "\t-k x\t\talphabet size (default 26)\n"
+               "\t-n x\t\tnumber of words for every word length (default 10000)\n"
+               "\t-s x\t\tseed for random generator (default 1)\n"
+               "\t-w prefix\twrite generated patterns and words to files starting with prefix\n"
+               "\t-m file\t\tmeasure merging of codes and extraction of breaks with patterns from file\n"
+               "\t-f file\t\twords used with -m (default assets/english_words.dic)\n";
+
+// Longest list that can be passed to -p, -l or -a options
+#define MAXLISTLEN 32
+
+// Judy and cprops trie keep byte offsets of characters in char
+#define MAXWORDBYTES 127
+
+// How many times all words are processed by merge microbenchmark
+#define MERGE_REPEAT 10
+
+/**
+ * Pattern found in word for merge microbenchmark. Hits of every word are
+ * stored one after another.
+ */
+typedef struct
+{
+    const char *code;
+    int position;
+    int len;
+} Merge_hit;
+
+// Letters used for 1 byte alphabet, digits and dots can not be used
+static const char ascii_alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+// First code point of 2 byte (Cyrillic) and 3 byte (Georgian) alphabet
+#define TWO_BYTE_BASE 0x0430
+#define THREE_BYTE_BASE 0x10D0
+
+// Private bench.c function which writes character with index into buffer
+static int encode_char(int index, int char_bytes, char *buffer)
+{
+    int code_point;
+
+    switch (char_bytes)
+    {
+    case 1:
+        buffer[0] = ascii_alphabet[index];
+        return 1;
+    case 2:
+        code_point = TWO_BYTE_BASE + index;
+        buffer[0] = 0xC0 | (code_point >> 6);
+        buffer[1] = 0x80 | (code_point & 0x3F);
+        return 2;
+    default:
+        code_point = THREE_BYTE_BASE + index;
+        buffer[0] = 0xE0 | (code_point >> 12);
+        buffer[1] = 0x80 | ((code_point >> 6) & 0x3F);
+        buffer[2] = 0x80 | (code_point & 0x3F);
+        return 3;
+    }
+}
+
+int bench_generate_patterns(Pattern_wrapper *patterns, int count, int char_bytes,
+                            int alphabet_size, unsigned int *seed)
+{
+    patterns->count = 0;
+    patterns->patterns = malloc(count * sizeof(Pattern));
+    if (patterns->patterns == NULL)
+    {
+        printf("Allocation error\n");
+        return 1;
+    }
+
+    // Judy is used only to skip patterns which were already generated
+    Pvoid_t generated = (Pvoid_t)NULL;
+    Word_t *PValue;
+    char buffer[16 * 3 + 3];
+    long attempts = 0;
+
+    while (patterns->count < count && attempts++ < 20L * count)
+    {
+        // Pattern lengths 1 to 7 with the most of them around 4 characters
+        int len = 1 + rand_r(seed) % 3 + rand_r(seed) % 3 + rand_r(seed) % 3;
+        int index = 0;
+        int chars = 0;
+
+        if (rand_r(seed) % 10 == 0)
+        {
+            buffer[index++] = '.';
+            chars++;
+        }
+
+        for (int i = 0; i < len; i++, chars++)
+            index += encode_char(rand_r(seed) % alphabet_size, char_bytes, &buffer[index]);
+
+        if (rand_r(seed) % 10 == 0)
+        {
+            buffer[index++] = '.';
+            chars++;
+        }
+        buffer[index] = '\0';
+
+        JSLI(PValue, generated, (uint8_t *)buffer);
+        if (*PValue)
+            continue;
+        *PValue = 1;
+
+        Pattern *pattern = &patterns->patterns[patterns->count];
+        pattern->word = strdup(buffer);
+        pattern->code = calloc(CODE_PADDED_SIZE(chars), sizeof(char));
+        if (pattern->word == NULL || pattern->code == NULL)
+        {
+            printf("Allocation error\n");
+            return 1;
+        }
+        patterns->count++;
+
+        // Every pattern has at least one non zero value
+        for (int i = 0; i <= chars; i++)
+            if (rand_r(seed) % 4 == 0)
+                pattern->code[i] = 1 + rand_r(seed) % 5;
+        pattern->code[rand_r(seed) % (chars + 1)] = 1 + rand_r(seed) % 5;
+    }
+
+    Word_t freed_count;
+    JSLFA(freed_count, generated);
+
+    if (patterns->count < count)
+        fprintf(stderr, "Only %i unique patterns could be generated\n", patterns->count);
+
+    return 0;
+}
+
+int bench_load_lengths(Bench_lengths *lengths, const char *word_file, int max_length)
+{
+    snprintf(lengths->label, sizeof(lengths->label), "dic");
+    lengths->min = 0;
+    lengths->max = 0;
+    lengths->histogram = NULL;
+
+    FILE *fp = fopen(word_file, "r");
+    if (fp == NULL)
+    {
+        printf("Cannot open file %s\n", word_file);
+        return 1;
+    }
+
+    lengths->histogram = calloc(max_length + 1, sizeof(long));
+    if (lengths->histogram == NULL)
+    {
+        printf("Allocation error\n");
+        fclose(fp);
+        return 1;
+    }
+
+    char *line = NULL;
+    size_t line_len = 0;
+    ssize_t read;
+
+    while ((read = getline(&line, &line_len, fp)) != -1)
+    {
+        if (read > 0 && line[read - 1] == '\n')
+            line[--read] = '\0';
+        if (read == 0 || line[0] == ':')
+            continue;
+
+        int len = strlen_utf8(line);
+        if (len > max_length)
+            continue;
+
+        lengths->histogram[len]++;
+        if (lengths->min == 0 || len < lengths->min)
+            lengths->min = len;
+        if (len > lengths->max)
+            lengths->max = len;
+    }
+
+    fclose(fp);
+    free(line);
+
+    if (lengths->max == 0)
+    {
+        printf("No word was loaded from %s\n", word_file);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Private bench.c function which draws length of one word from lengths, total
+ * is the number of words of histogram which can be drawn.
+ */
+static int bench_draw_length(const Bench_lengths *lengths, long total, unsigned int *seed)
+{
+    int len = lengths->min;
+
+    if (lengths->histogram)
+        for (long r = rand_r(seed) % total; r >= lengths->histogram[len]; len++)
+            r -= lengths->histogram[len];
+    else
+        len += rand_r(seed) % (lengths->max - len + 1);
+
+    return len;
+}
+
+char **bench_generate_words(int count, const Bench_lengths *lengths, int max_length,
+                            int char_bytes, int alphabet_size, unsigned int *seed)
+{
+    char **words = calloc(count, sizeof(char *));
+    if (words == NULL)
+        return NULL;
+
+    // Only words of lengths up to max_length are drawn from histogram
+    long total = 0;
+    if (lengths->histogram)
+        for (int l = lengths->min; l <= lengths->max && l <= max_length; l++)
+            total += lengths->histogram[l];
+
+    for (int i = 0; i < count; i++)
+    {
+        int word_length = bench_draw_length(lengths, total, seed);
+
+        words[i] = calloc(word_length * char_bytes + 1, sizeof(char));
+        if (words[i] == NULL)
+            return NULL;
+
+        int index = 0;
+        for (int j = 0; j < word_length; j++)
+            index += encode_char(rand_r(seed) % alphabet_size, char_bytes, &words[i][index]);
+    }
+
+    return words;
+}
+
+// Private bench.c function which writes generated words into file
+static int bench_write_words(char **words, int word_count, const char *file_name)
+{
+    FILE *fp = fopen(file_name, "w");
+    if (fp == NULL)
+    {
+        printf("Cannot open file %s\n", file_name);
+        return 1;
+    }
+
+    for (int i = 0; i < word_count; i++)
+        fprintf(fp, "%s\n", words[i]);
+
+    fclose(fp);
+    return 0;
+}
+
+void bench_run(Pattern_wrapper *patterns, char **words, int word_count, const char *label,
+               int char_bytes)
+{
+    char **dotted_words = calloc(word_count, sizeof(char *));
+    char **utf8_codes = calloc(word_count, sizeof(char *));
+    char **results = calloc(word_count, sizeof(char *));
+    if (dotted_words == NULL || utf8_codes == NULL || results == NULL)
+    {
+        printf("Allocation error\n");
+        return;
+    }
+
+    // Every word is searched for all of its substrings including dots
+    long length_sum = 0;
+    long probe_sum = 0;
+
+    for (int i = 0; i < word_count; i++)
+    {
+        int word_length = strlen(words[i]) / char_bytes;
+        length_sum += word_length;
+        probe_sum += (word_length + 2) * (word_length + 3) / 2;
+
+        dotted_words[i] = add_dots_to_word(strlen(words[i]), words[i]);
+        utf8_codes[i] = create_utf_array(dotted_words[i]);
+    }
+
+    for (int b = 0; b < BACKEND_COUNT; b++)
+    {
+        size_t heap_before = heap_usage();
+        void *structure = backends[b].create(patterns);
+        double bytes = heap_usage() - heap_before;
+        if (structure == NULL)
+            continue;
+
+        STARTTm;
+        for (int i = 0; i < word_count; i++)
+            results[i] = backends[b].hyphenate(dotted_words[i], structure, utf8_codes[i]);
+        ENDTm;
+
+        printf("%-8s %9i %6i %6s %8.2f %8.1f %14.3f %12.1f\n", backends[b].name,
+               patterns->count, char_bytes, label, (double)length_sum / word_count,
+               (double)probe_sum / word_count, DeltaUSec / word_count, bytes / patterns->count);
+        fflush(stdout);
+
+        for (int i = 0; i < word_count; i++)
+            free(results[i]);
+        backends[b].destroy(structure);
+    }
+
+    for (int i = 0; i < word_count; i++)
+    {
+        free(dotted_words[i]);
+        free(utf8_codes[i]);
+    }
+    free(dotted_words);
+    free(utf8_codes);
+    free(results);
+}
+
+/**
+ * Private bench.c function which merges all hits of every word and extracts
+ * breaks MERGE_REPEAT times. Returns the number of found breaks.
+ */
+static long bench_merge_pass(int word_count, const int *lengths, const int *first_hits,
+                             const Merge_hit *hits, bool vector)
+{
+    long hyphen_count = 0;
+
+    for (int r = 0; r < MERGE_REPEAT; r++)
+        for (int w = 0; w < word_count; w++)
+        {
+            char hyph_code[HYPH_CODE_SIZE(lengths[w])];
+            uint64_t breaks[CODE_BREAK_WORDS(lengths[w])];
+            memset(hyph_code, 0, sizeof(hyph_code));
+
+            for (int h = first_hits[w]; h < first_hits[w + 1]; h++)
+                if (vector)
+                    code_merge(&hyph_code[hits[h].position], hits[h].code, hits[h].len);
+                else
+                    code_merge_scalar(&hyph_code[hits[h].position], hits[h].code, hits[h].len);
+
+            hyphen_count += vector ? code_breaks(hyph_code, lengths[w], breaks)
+                                   : code_breaks_scalar(hyph_code, lengths[w], breaks);
+        }
+
+    return hyphen_count;
+}
+
+int bench_merge(const char *patterns_file, const char *words_file)
+{
+    Pattern_wrapper pattern_list;
+    if (patterns_load(&pattern_list, patterns_file))
+    {
+        patterns_free(&pattern_list);
+        return 1;
+    }
+
+    Pvoid_t pattern_judy = (Pvoid_t)NULL;
+    judy_insert_patterns(&pattern_list, &pattern_judy);
+
+    FILE *fp = fopen(words_file, "r");
+    if (fp == NULL)
+    {
+        printf("Cannot open file %s\n", words_file);
+        return 1;
+    }
+
+    int allocated_words = 1024;
+    int allocated_hits = 16384;
+    int word_count = 0;
+    int hit_count = 0;
+    int *lengths = malloc(allocated_words * sizeof(int));
+    int *first_hits = malloc((allocated_words + 1) * sizeof(int));
+    Merge_hit *hits = malloc(allocated_hits * sizeof(Merge_hit));
+    char *line = NULL;
+    size_t line_len = 0;
+    ssize_t read;
+
+    // All hits are found before timing, so only merging and extraction is measured
+    while ((read = getline(&line, &line_len, fp)) != -1)
+    {
+        if (read > 0 && line[read - 1] == '\n')
+            line[--read] = '\0';
+        if (read == 0 || read + 2 > MAXWORDBYTES)
+            continue;
+
+        if (word_count == allocated_words)
+        {
+            allocated_words *= 2;
+            lengths = realloc(lengths, allocated_words * sizeof(int));
+            first_hits = realloc(first_hits, (allocated_words + 1) * sizeof(int));
+        }
+
+        char *word = add_dots_to_word(read, line);
+        char *utf8_code = create_utf_array(word);
+        int len = strlen_utf8(word);
+        Word_t *PValue;
+
+        lengths[word_count] = len;
+        first_hits[word_count] = hit_count;
+
+        for (int j = 0; j < len; j++)
+            for (int i = j + 1; i <= len; i++)
+            {
+                char backup = word[(int)utf8_code[i]];
+                word[(int)utf8_code[i]] = '\0';
+                JSLG(PValue, pattern_judy, (uint8_t *)&word[(int)utf8_code[j]]);
+                word[(int)utf8_code[i]] = backup;
+
+                if (PValue == NULL)
+                    continue;
+
+                if (hit_count == allocated_hits)
+                {
+                    allocated_hits *= 2;
+                    hits = realloc(hits, allocated_hits * sizeof(Merge_hit));
+                }
+                hits[hit_count++] = (Merge_hit){(const char *)*PValue, j, i - j};
+            }
+
+        free(word);
+        free(utf8_code);
+        word_count++;
+
+        if (lengths == NULL || first_hits == NULL || hits == NULL)
+        {
+            printf("Allocation error\n");
+            return 1;
+        }
+    }
+    first_hits[word_count] = hit_count;
+
+    fclose(fp);
+    if (line)
+        free(line);
+
+    printf("%-8s %9s %9s %14s %9s\n", "kernel", "words", "hits", "usec_per_word", "breaks");
+
+    for (int vector = 0; vector <= 1; vector++)
+    {
+        STARTTm;
+        long hyphen_count = bench_merge_pass(word_count, lengths, first_hits, hits, vector);
+        ENDTm;
+
+        printf("%-8s %9i %9i %14.4f %9li\n", vector ? "vector" : "scalar", word_count,
+               hit_count, DeltaUSec / ((double)word_count * MERGE_REPEAT),
+               hyphen_count / MERGE_REPEAT);
+    }
+
+#ifndef __SSE2__
+    fprintf(stderr, "SSE2 is not available, vector kernel uses scalar fallback\n");
+#endif
+
+    Word_t freed_count;
+    JSLFA(freed_count, pattern_judy);
+    patterns_free(&pattern_list);
+    free(lengths);
+    free(first_hits);
+    free(hits);
+
+    return 0;
+}
+
+// Private bench.c function for parsing comma separated list of numbers
+static int parse_list(char *arg, int *list)
+{
+    int count = 0;
+    for (char *token = strtok(arg, ","); token && count < MAXLISTLEN; token = strtok(NULL, ","))
+        list[count++] = atoi(token);
+
+    return count;
+}
+
+// Private bench.c function for parsing comma separated list of lengths x or min-max
+static int parse_lengths(char *arg, Bench_lengths *list)
+{
+    int count = 0;
+    for (char *token = strtok(arg, ","); token && count < MAXLISTLEN; token = strtok(NULL, ","))
+    {
+        Bench_lengths *lengths = &list[count++];
+        char *range = strchr(token, '-');
+
+        lengths->min = atoi(token);
+        lengths->max = range ? atoi(range + 1) : lengths->min;
+        lengths->histogram = NULL;
+        snprintf(lengths->label, sizeof(lengths->label), "%s", token);
+    }
+
+    return count;
+}
+
+int main(int argc, char **argv)
+{
+    // Check for valid size of judy's internal type
+    assert(sizeof(Word_t) == sizeof(char *));
+
+    int pattern_counts[MAXLISTLEN] = {1000, 10000, 100000, 1000000};
+    int pattern_counts_len = 4;
+    char default_lengths[] = "4,8,16,32";
+    char *lengths_arg = default_lengths;
+    char *lengths_file = NULL;
+    Bench_lengths word_lengths[MAXLISTLEN + 1];
+    int char_bytes[MAXLISTLEN] = {1, 2, 3};
+    int char_bytes_len = 3;
+    int alphabet_size = 26;
+    int word_count = 10000;
+    unsigned int seed = 1;
+    char *output_prefix = NULL;
+    char *merge_patterns_file = NULL;
+    char *merge_words_file = "assets/english_words.dic";
+
+    int c;
+    while ((c = getopt(argc, argv, "hp:l:d:a:k:n:s:w:m:f:")) != -1)
+        switch (c)
+        {
+        case 'h':
+            printf("%s", usage);
+            return 0;
+        case 'p':
+            pattern_counts_len = parse_list(optarg, pattern_counts);
+            break;
+        case 'l':
+            lengths_arg = optarg;
+            break;
+        case 'd':
+            lengths_file = optarg;
+            break;
+        case 'a':
+            char_bytes_len = parse_list(optarg, char_bytes);
+            break;
+        case 'k':
+            alphabet_size = atoi(optarg);
+            break;
+        case 'n':
+            word_count = atoi(optarg);
+            break;
+        case 's':
+            seed = atoi(optarg);
+            break;
+        case 'w':
+            output_prefix = optarg;
+            break;
+        case 'm':
+            merge_patterns_file = optarg;
+            break;
+        case 'f':
+            merge_words_file = optarg;
+            break;
+        default:
+            fprintf(stderr, "Unknown option `\\x%x'.\n", optopt);
+            return 1;
+        }
+
+    if (merge_patterns_file)
+        return bench_merge(merge_patterns_file, merge_words_file);
+
+    if (alphabet_size < 1 || alphabet_size > (int)strlen(ascii_alphabet) || word_count < 1)
+    {
+        fprintf(stderr, "Alphabet size must be between 1 and %i and word count higher than 0\n",
+                (int)strlen(ascii_alphabet));
+        return 1;
+    }
+
+    // Histogram of word file is the last distribution
+    int word_lengths_len = parse_lengths(lengths_arg, word_lengths);
+    if (lengths_file &&
+        bench_load_lengths(&word_lengths[word_lengths_len++], lengths_file, MAXWORDBYTES - 2))
+    {
+        free(word_lengths[word_lengths_len - 1].histogram);
+        return 1;
+    }
+
+    printf("%-8s %9s %6s %6s %8s %8s %14s %12s\n", "backend", "patterns", "bytes",
+           "length", "mean_len", "probes", "usec_per_word", "bytes_per_pat");
+
+    for (int a = 0; a < char_bytes_len; a++)
+    {
+        if (char_bytes[a] < 1 || char_bytes[a] > 3)
+        {
+            fprintf(stderr, "Skipping %i bytes per character, only 1 to 3 are supported\n", char_bytes[a]);
+            continue;
+        }
+
+        for (int p = 0; p < pattern_counts_len; p++)
+        {
+            Pattern_wrapper pattern_list;
+            if (bench_generate_patterns(&pattern_list, pattern_counts[p], char_bytes[a],
+                                        alphabet_size, &seed))
+            {
+                patterns_free(&pattern_list);
+                return 1;
+            }
+
+            char file_name[4096];
+            if (output_prefix)
+            {
+                snprintf(file_name, sizeof(file_name), "%s_%i_%i.pat", output_prefix,
+                         pattern_counts[p], char_bytes[a]);
+                patterns_save(&pattern_list, file_name);
+            }
+
+            for (int l = 0; l < word_lengths_len; l++)
+            {
+                Bench_lengths *lengths = &word_lengths[l];
+                int max_length = (MAXWORDBYTES - 2) / char_bytes[a];
+
+                // Longer words of histogram are only left out
+                if (lengths->min < 1 || lengths->max < lengths->min ||
+                    (lengths->histogram ? lengths->min : lengths->max) > max_length)
+                {
+                    fprintf(stderr, "Skipping word length %s with %i bytes per character\n",
+                            lengths->label, char_bytes[a]);
+                    continue;
+                }
+
+                char **words = bench_generate_words(word_count, lengths, max_length,
+                                                    char_bytes[a], alphabet_size, &seed);
+                if (words == NULL)
+                {
+                    printf("Allocation error\n");
+                    patterns_free(&pattern_list);
+                    return 1;
+                }
+
+                if (output_prefix)
+                {
+                    snprintf(file_name, sizeof(file_name), "%s_%i_%i_%s.dic", output_prefix,
+                             pattern_counts[p], char_bytes[a], lengths->label);
+                    bench_write_words(words, word_count, file_name);
+                }
+
+                bench_run(&pattern_list, words, word_count, lengths->label, char_bytes[a]);
+
+                for (int i = 0; i < word_count; i++)
+                    free(words[i]);
+                free(words);
+            }
+
+            patterns_free(&pattern_list);
+        }
+    }
+
+    for (int l = 0; l < word_lengths_len; l++)
+        free(word_lengths[l].histogram);
+
+    return 0;
+}
@@ -2,8 +2,12 @@
 
 #include "compare.h"
 #include "patterns.h"
+#include "alphabet.h"
 #include "judy.h"
+#include "judytrie.h"
 #include "trie.h"
+#include "packed.h"
+#include "prune.h"
 #include "utils.h"
 
 #include <ctype.h>
@@ -12,23 +16,105 @@
 #include <unistd.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <pthread.h>
+#include <time.h>
 
 // Global constants
-int left_hyphen_min = 2;
-int right_hyphen_min = 2;
+__thread int left_hyphen_min = 2;
+__thread int right_hyphen_min = 2;
 bool verbose = false;
 char hyphenation_char = '-';
+int batch_size = 16;
+bool incremental = false;
 
-// Private compare.c function to print out results of time testing
-void print_results(double time_judy, double time_trie, int word_count)
+// Batches are kept on stack, so their size is limited
+#define MAXBATCHSIZE 1024
+
+// Most threads which can be used by -T
+#define MAXTHREADCOUNT 256
+
+// How many times both layouts of packed trie hyphenate all words with -L
+#define LAYOUT_REPEAT 5
+
+/**
+ * Data structure shared by all threads of concurrent benchmark. Hyphenate
+ * must only read the structure, so it can be called from many threads.
+ */
+typedef struct
 {
-    printf("Hyphenation results\n");
-    printf("Hyphenating %i words with patterns stored in Judy        took %8.0f"
-           " microseconds total, %4.3f miliseconds per word\n",
-           word_count, time_judy, time_judy / word_count);
-    printf("Hyphenating %i words with patterns stored in cprops Trie took %8.0f"
+    const char *name;
+    char *(*hyphenate)(char *word, void *structure, const char *utf8_code);
+    void *structure;
+} Concurrent_backend;
+
+// Words of one thread of concurrent benchmark and its measured time
+typedef struct
+{
+    const Concurrent_backend *backend;
+    pthread_barrier_t *start;
+    char **words;
+    char **utf8_codes;
+    int count;
+    int left_hyphen_min;
+    int right_hyphen_min;
+    double time;
+} Concurrent_thread;
+
+// Private compare.c function to print out result of one data structure
+void print_result(const char *name, double time, int word_count)
+{
+    printf("Hyphenating %i words with patterns stored in %-11s took %8.0f"
            " microseconds total, %4.3f miliseconds per word\n",
-           word_count, time_trie, time_trie / word_count);
+           word_count, name, time, time / word_count);
+}
+
+/**
+ * Private compare.c function which hyphenates batch of words with interleaved
+ * Judy lookups and if pattern_packed is not NULL also with interleaved
+ * descents of packed trie. Results are checked against results of
+ * judy_hyphenate and all memory of the batch is freed. Returns count of
+ * different results.
+ */
+int compare_batch(char **words, char **utf8_codes, char **judy_results, int count,
+                  Pvoid_t *pattern_judy, double *time_batch, Packed_trie *pattern_packed,
+                  double *time_packed_batch)
+{
+    char *batch_results[count];
+    char *packed_results[count];
+    int mismatch_count = 0;
+
+    STARTTm;
+    judy_hyphenate_batch(words, utf8_codes, count, pattern_judy, batch_results);
+    ENDTm;
+    *time_batch += DeltaUSec;
+
+    if (pattern_packed)
+    {
+        STARTTm;
+        packed_hyphenate_batch(words, utf8_codes, count, pattern_packed, packed_results);
+        ENDTm;
+        *time_packed_batch += DeltaUSec;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (batch_results[i] == NULL || strcmp(batch_results[i], judy_results[i]) != 0)
+            mismatch_count++;
+
+        if (pattern_packed)
+        {
+            if (packed_results[i] == NULL || strcmp(packed_results[i], judy_results[i]) != 0)
+                mismatch_count++;
+            free(packed_results[i]);
+        }
+
+        free(batch_results[i]);
+        free(judy_results[i]);
+        free(utf8_codes[i]);
+        free(words[i]);
+    }
+
+    return mismatch_count;
 }
 
 void space_test_judy(Pattern_wrapper *pattern_list)
@@ -42,6 +128,15 @@ void space_test_judy(Pattern_wrapper *pattern_list)
     patterns_free(pattern_list);
 }
 
+void space_test_judy_trie(Pattern_wrapper *pattern_list)
+{
+    Judy_trie pattern_judy_trie = {NULL, 0};
+    judy_trie_insert_patterns(pattern_list, &pattern_judy_trie);
+    judy_trie_free(&pattern_judy_trie);
+
+    patterns_free(pattern_list);
+}
+
 void space_test_trie(Pattern_wrapper *pattern_list)
 {
     cp_trie *pattern_trie = cp_trie_create(COLLECTION_MODE_NOSYNC);
@@ -52,7 +147,426 @@ void space_test_trie(Pattern_wrapper *pattern_list)
     patterns_free(pattern_list);
 }
 
-void compare(const char *file_name, Pvoid_t *pattern_judy, cp_trie *pattern_trie)
+void space_test_packed(Pattern_wrapper *pattern_list)
+{
+    Packed_trie pattern_packed;
+    if (packed_build(pattern_list, &pattern_packed, false) == 0)
+        packed_free(&pattern_packed);
+
+    patterns_free(pattern_list);
+}
+
+static char *concurrent_judy(char *word, void *structure, const char *utf8_code)
+{
+    return judy_hyphenate(word, structure, utf8_code);
+}
+
+static char *concurrent_trie(char *word, void *structure, const char *utf8_code)
+{
+    return trie_hyphenate(word, structure, utf8_code);
+}
+
+static char *concurrent_packed(char *word, void *structure, const char *utf8_code)
+{
+    return packed_hyphenate(word, structure, utf8_code);
+}
+
+static char *concurrent_judy_trie(char *word, void *structure, const char *utf8_code)
+{
+    return judy_trie_hyphenate(word, structure, utf8_code);
+}
+
+// Private compare.c function which returns monotonic time in microseconds
+static double concurrent_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000.0 + now.tv_nsec / 1000.0;
+}
+
+/**
+ * Private compare.c function of one thread of concurrent benchmark. Global
+ * timing macros are shared by all threads, so time is measured locally.
+ */
+static void *concurrent_thread(void *arg)
+{
+    Concurrent_thread *thread = arg;
+    left_hyphen_min = thread->left_hyphen_min;
+    right_hyphen_min = thread->right_hyphen_min;
+
+    pthread_barrier_wait(thread->start);
+
+    double begin = concurrent_now();
+    for (int i = 0; i < thread->count; i++)
+        free(thread->backend->hyphenate(thread->words[i], thread->backend->structure,
+                                        thread->utf8_codes[i]));
+    thread->time = concurrent_now() - begin;
+
+    return NULL;
+}
+
+/**
+ * Private compare.c function which hyphenates all words with thread_count
+ * threads, every thread gets its own continuous part of words. Prints one
+ * result line.
+ */
+static void concurrent_run(const Concurrent_backend *backend, char **words, char **utf8_codes,
+                           int word_count, int thread_count)
+{
+    pthread_t threads[thread_count];
+    Concurrent_thread args[thread_count];
+    pthread_barrier_t start;
+
+    pthread_barrier_init(&start, NULL, thread_count + 1);
+
+    for (int t = 0; t < thread_count; t++)
+    {
+        int first = (long)word_count * t / thread_count;
+        int last = (long)word_count * (t + 1) / thread_count;
+
+        args[t] = (Concurrent_thread){backend, &start, &words[first], &utf8_codes[first],
+                                      last - first, left_hyphen_min, right_hyphen_min, 0};
+        if (pthread_create(&threads[t], NULL, concurrent_thread, &args[t]))
+        {
+            printf("Thread creation error\n");
+            exit(1);
+        }
+    }
+
+    // Wall time starts when all threads are ready
+    pthread_barrier_wait(&start);
+    double begin = concurrent_now();
+
+    for (int t = 0; t < thread_count; t++)
+        pthread_join(threads[t], NULL);
+    double wall_time = concurrent_now() - begin;
+
+    pthread_barrier_destroy(&start);
+
+    double latency_sum = 0;
+    double latency_max = 0;
+    for (int t = 0; t < thread_count; t++)
+    {
+        double latency = args[t].count ? args[t].time / args[t].count : 0;
+        latency_sum += latency;
+        if (latency > latency_max)
+            latency_max = latency;
+    }
+
+    printf("%7i %-16s %14.0f %12.3f %12.3f\n", thread_count, backend->name,
+           word_count / (wall_time / 1000000.0), latency_sum / thread_count, latency_max);
+    fflush(stdout);
+}
+
+void compare_threads(const char *file_name, int max_threads, Pvoid_t *pattern_judy,
+                     cp_trie *pattern_trie, cp_trie *pattern_trie_sync,
+                     Packed_trie *pattern_packed, Judy_trie *pattern_judy_trie)
+{
+    FILE *fp;
+    char *line = NULL;
+    size_t len = 0;
+    ssize_t read;
+
+    int allocated_count = 1024;
+    int word_count = 0;
+    char **words = malloc(allocated_count * sizeof(char *));
+    char **utf8_codes = malloc(allocated_count * sizeof(char *));
+    if (words == NULL || utf8_codes == NULL)
+    {
+        printf("Allocation error\n");
+        return;
+    }
+
+    fp = fopen(file_name, "r");
+    if (fp == NULL)
+    {
+        printf("Cannot open file %s\n", file_name);
+        return;
+    }
+
+    // All words are prepared before threads start
+    while ((read = getline(&line, &len, fp)) != -1)
+    {
+        // Remove new line character
+        if (line[read - 1] == '\n')
+        {
+            line[read - 1] = '\0';
+            read--;
+        }
+
+        // Skip if no word was loaded
+        if (read == 0)
+            continue;
+
+        if (word_count == allocated_count)
+        {
+            allocated_count *= 2;
+            words = realloc(words, allocated_count * sizeof(char *));
+            utf8_codes = realloc(utf8_codes, allocated_count * sizeof(char *));
+            if (words == NULL || utf8_codes == NULL)
+            {
+                printf("Allocation error\n");
+                return;
+            }
+        }
+
+        words[word_count] = add_dots_to_word(read, line);
+        utf8_codes[word_count] = create_utf_array(words[word_count]);
+        word_count++;
+    }
+
+    fclose(fp);
+    if (line)
+        free(line);
+
+    Concurrent_backend backends[] = {
+        {"Judy", concurrent_judy, pattern_judy},
+        {"cprops Trie", concurrent_trie, pattern_trie},
+        {"cprops Trie sync", concurrent_trie, pattern_trie_sync},
+        {"Packed trie", concurrent_packed, pattern_packed},
+        {"Judy trie", concurrent_judy_trie, pattern_judy_trie},
+    };
+
+    printf("Concurrent hyphenation of %i words, every thread reads shared data structure\n",
+           word_count);
+    printf("%7s %-16s %14s %12s %12s\n", "threads", "structure", "words_per_sec",
+           "usec_avg", "usec_max");
+
+    // Thread counts are doubled up to max_threads
+    for (int thread_count = 1;; thread_count *= 2)
+    {
+        if (thread_count > max_threads)
+            thread_count = max_threads;
+
+        for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++)
+            if (backends[b].structure)
+                concurrent_run(&backends[b], words, utf8_codes, word_count, thread_count);
+
+        if (thread_count == max_threads)
+            break;
+    }
+
+    for (int i = 0; i < word_count; i++)
+    {
+        free(words[i]);
+        free(utf8_codes[i]);
+    }
+    free(words);
+    free(utf8_codes);
+}
+
+void compare_pruned(const char *file_name, Pattern_wrapper *pattern_list)
+{
+    Pattern_wrapper pruned_list;
+    Prune_stats stats;
+    if (prune_patterns(pattern_list, &pruned_list, &stats))
+        return;
+
+    // Memory of Judy is measured by heap usage during insertion
+    Pvoid_t original_judy = (Pvoid_t)NULL;
+    Pvoid_t pruned_judy = (Pvoid_t)NULL;
+    size_t heap_before = heap_usage();
+    judy_insert_patterns(pattern_list, &original_judy);
+    size_t original_bytes = heap_usage() - heap_before;
+
+    heap_before = heap_usage();
+    judy_insert_patterns(&pruned_list, &pruned_judy);
+    size_t pruned_bytes = heap_usage() - heap_before;
+
+    double time_original = 0;
+    double time_pruned = 0;
+    int different_count = prune_verify(file_name, &original_judy, &pruned_judy,
+                                       &time_original, &time_pruned);
+
+    printf("Pruning removed %i duplicate and %i dominated patterns\n",
+           stats.duplicate_count, stats.dominated_count);
+    printf("%-28s %12s %12s\n", "", "before", "after");
+    printf("%-28s %12i %12i\n", "Patterns", pattern_list->count, pruned_list.count);
+    printf("%-28s %12zu %12zu\n", "Judy memory in bytes", original_bytes, pruned_bytes);
+    printf("%-28s %12.0f %12.0f\n", "Judy hyphenation in usec", time_original, time_pruned);
+
+    if (different_count == 0)
+        printf("Hyphenation of all words is identical\n");
+    else if (different_count > 0)
+        printf("Hyphenation differs in %i words\n", different_count);
+
+    Word_t freed_count;
+    JSLFA(freed_count, original_judy);
+    JSLFA(freed_count, pruned_judy);
+    patterns_free(&pruned_list);
+}
+
+/**
+ * Private compare.c function which hyphenates all words with packed trie.
+ * Returns time in microseconds, cache misses are added to misses or it is set
+ * to -1 if they can not be counted.
+ */
+static double compare_layout(const Packed_trie *trie, char **words, char **utf8_codes,
+                             char **results, int count, long long *misses)
+{
+    int fd = cache_misses_start();
+
+    STARTTm;
+    for (int i = 0; i < count; i++)
+        results[i] = packed_hyphenate(words[i], trie, utf8_codes[i]);
+    ENDTm;
+
+    long long count_misses = cache_misses_stop(fd);
+    if (count_misses < 0 || *misses < 0)
+        *misses = -1;
+    else
+        *misses += count_misses;
+
+    return DeltaUSec;
+}
+
+void compare_profiled(const char *file_name, const char *profile_file,
+                      Pattern_wrapper *pattern_list)
+{
+    Packed_trie original;
+    Packed_trie profiled;
+    if (packed_build(pattern_list, &original, false))
+        return;
+
+    uint32_t *hits = calloc(original.node_count, sizeof(uint32_t));
+    uint32_t *profiled_hits = calloc(original.node_count, sizeof(uint32_t));
+    if (hits == NULL || profiled_hits == NULL)
+    {
+        printf("Allocation error\n");
+        return;
+    }
+
+    int profile_count = packed_profile(&original, profile_file, hits);
+    if (profile_count < 0 || packed_relayout(&original, hits, &profiled, false))
+    {
+        packed_free(&original);
+        free(hits);
+        free(profiled_hits);
+        return;
+    }
+    packed_profile(&profiled, profile_file, profiled_hits);
+
+    uint32_t reached_count = 0;
+    for (uint32_t n = 1; n < original.node_count; n++)
+        reached_count += hits[n] > 0;
+
+    // Words are loaded first, so only hyphenation is measured
+    FILE *fp;
+    char *line = NULL;
+    size_t len = 0;
+    ssize_t read;
+    int word_count = 0;
+    int allocated_count = 1024;
+    char **words = malloc(allocated_count * sizeof(char *));
+    char **utf8_codes = malloc(allocated_count * sizeof(char *));
+
+    fp = fopen(file_name, "r");
+    if (fp == NULL)
+    {
+        printf("Cannot open file %s\n", file_name);
+        return;
+    }
+
+    while ((read = getline(&line, &len, fp)) != -1)
+    {
+        // Remove new line character
+        if (line[read - 1] == '\n')
+        {
+            line[read - 1] = '\0';
+            read--;
+        }
+
+        // Skip if no word was loaded
+        if (read == 0)
+            continue;
+
+        if (word_count == allocated_count)
+        {
+            allocated_count *= 2;
+            words = realloc(words, allocated_count * sizeof(char *));
+            utf8_codes = realloc(utf8_codes, allocated_count * sizeof(char *));
+        }
+        if (words == NULL || utf8_codes == NULL)
+        {
+            printf("Allocation error\n");
+            return;
+        }
+
+        words[word_count] = add_dots_to_word(read, line);
+        utf8_codes[word_count] = create_utf_array(words[word_count]);
+        word_count++;
+    }
+
+    fclose(fp);
+    if (line)
+        free(line);
+
+    char **original_results = malloc(word_count * sizeof(char *));
+    char **profiled_results = malloc(word_count * sizeof(char *));
+    if (original_results == NULL || profiled_results == NULL)
+    {
+        printf("Allocation error\n");
+        return;
+    }
+
+    // Layouts take turns, so both run with similar state of caches
+    double time_original = 0;
+    double time_profiled = 0;
+    long long misses_original = 0;
+    long long misses_profiled = 0;
+    int different_count = 0;
+
+    for (int r = 0; r < LAYOUT_REPEAT; r++)
+    {
+        time_original += compare_layout(&original, words, utf8_codes, original_results,
+                                        word_count, &misses_original);
+        time_profiled += compare_layout(&profiled, words, utf8_codes, profiled_results,
+                                        word_count, &misses_profiled);
+
+        for (int i = 0; i < word_count; i++)
+        {
+            if (r == 0 && strcmp(original_results[i], profiled_results[i]) != 0)
+                different_count++;
+            free(original_results[i]);
+            free(profiled_results[i]);
+        }
+    }
+
+    printf("Profile of %i words reached %u of %u nodes of packed trie\n",
+           profile_count, reached_count, original.node_count - 1);
+    printf("%-28s %12s %12s\n", "", "unprofiled", "profiled");
+    printf("%-28s %12u %12u\n", "Cache lines of hottest nodes", packed_hot_lines(&original, hits),
+           packed_hot_lines(&profiled, profiled_hits));
+    printf("%-28s %12.0f %12.0f\n", "Packed hyphenation in usec", time_original / LAYOUT_REPEAT,
+           time_profiled / LAYOUT_REPEAT);
+    if (misses_original >= 0 && misses_profiled >= 0)
+        printf("%-28s %12lld %12lld\n", "Cache misses", misses_original / LAYOUT_REPEAT,
+               misses_profiled / LAYOUT_REPEAT);
+    else
+        printf("%-28s %12s %12s\n", "Cache misses", "n/a", "n/a");
+
+    if (different_count == 0)
+        printf("Hyphenation of all words is identical\n");
+    else
+        printf("Hyphenation differs in %i words\n", different_count);
+
+    for (int i = 0; i < word_count; i++)
+    {
+        free(words[i]);
+        free(utf8_codes[i]);
+    }
+    free(words);
+    free(utf8_codes);
+    free(original_results);
+    free(profiled_results);
+    free(hits);
+    free(profiled_hits);
+    packed_free(&original);
+    packed_free(&profiled);
+}
+
+void compare(const char *file_name, Pvoid_t *pattern_judy, cp_trie *pattern_trie,
+             Packed_trie *pattern_packed, Judy_trie *pattern_judy_trie, Alphabet *alphabet)
 {
     FILE *fp;
     char *line = NULL;
@@ -61,9 +575,23 @@ void compare(const char *file_name, Pvoid_t *pattern_judy, cp_trie *pattern_trie
 
     double time_judy = 0;
     double time_trie = 0;
+    double time_batch = 0;
+    double time_packed = 0;
+    double time_packed_batch = 0;
+    double time_judy_trie = 0;
+    double time_incremental = 0;
+    Judy_incremental incremental_state = {0};
     char *word = NULL;
     int word_count = 0;
 
+    // Transcoded words are not hyphenated in batches
+    char *batch_words[batch_size];
+    char *batch_codes[batch_size];
+    char *batch_results[batch_size];
+    int batch_count = 0;
+    int mismatch_count = 0;
+    int different_count = 0;
+
     fp = fopen(file_name, "r");
     if (fp == NULL)
     {
@@ -85,31 +613,139 @@ void compare(const char *file_name, Pvoid_t *pattern_judy, cp_trie *pattern_trie
             continue;
 
         word = add_dots_to_word(read, line);
-        char *utf8_code = create_utf_array(word);
+
+        // Transcoded words need no utf8 offsets
+        char *utf8_code = NULL;
+        unsigned char symbols[read + 3];
+        int symbol_count = 0;
+        if (alphabet)
+            symbol_count = alphabet_transcode(alphabet, word, symbols);
+        else
+            utf8_code = create_utf_array(word);
 
         STARTTm;
-        char *judy_hyphenated = judy_hyphenate(word, pattern_judy, utf8_code);
+        char *judy_hyphenated = alphabet
+                                    ? judy_hyphenate_symbols(word, symbols, symbol_count, pattern_judy)
+                                    : judy_hyphenate(word, pattern_judy, utf8_code);
         ENDTm;
         time_judy += DeltaUSec;
 
         STARTTm;
-        char *trie_hyphenated = trie_hyphenate(word, pattern_trie, utf8_code);
+        char *trie_hyphenated = alphabet
+                                    ? trie_hyphenate_symbols(word, symbols, symbol_count, pattern_trie)
+                                    : trie_hyphenate(word, pattern_trie, utf8_code);
         ENDTm;
         time_trie += DeltaUSec;
 
+        if (pattern_packed)
+        {
+            STARTTm;
+            char *packed_hyphenated = packed_hyphenate(word, pattern_packed, utf8_code);
+            ENDTm;
+            time_packed += DeltaUSec;
+
+            if (strcmp(packed_hyphenated, judy_hyphenated) != 0)
+                different_count++;
+            free(packed_hyphenated);
+        }
+
+        // Sorted words share prefixes with the previous word
+        if (incremental && !alphabet)
+        {
+            STARTTm;
+            char *incremental_hyphenated = judy_hyphenate_incremental(word, pattern_judy, utf8_code,
+                                                                      &incremental_state);
+            ENDTm;
+            time_incremental += DeltaUSec;
+
+            if (strcmp(incremental_hyphenated, judy_hyphenated) != 0)
+                different_count++;
+            free(incremental_hyphenated);
+        }
+
+        if (pattern_judy_trie)
+        {
+            STARTTm;
+            char *judy_trie_hyphenated = judy_trie_hyphenate(word, pattern_judy_trie, utf8_code);
+            ENDTm;
+            time_judy_trie += DeltaUSec;
+
+            if (strcmp(judy_trie_hyphenated, judy_hyphenated) != 0)
+                different_count++;
+            free(judy_trie_hyphenated);
+        }
+
         word_count++;
-        free(judy_hyphenated);
+        if (strcmp(trie_hyphenated, judy_hyphenated) != 0)
+            different_count++;
         free(trie_hyphenated);
-        free(utf8_code);
+
+        if (alphabet)
+        {
+            free(judy_hyphenated);
+            free(word);
+            word = NULL;
+            continue;
+        }
+
+        batch_words[batch_count] = word;
+        batch_codes[batch_count] = utf8_code;
+        batch_results[batch_count] = judy_hyphenated;
+        word = NULL;
+
+        if (++batch_count == batch_size)
+        {
+            mismatch_count += compare_batch(batch_words, batch_codes, batch_results,
+                                            batch_count, pattern_judy, &time_batch,
+                                            pattern_packed, &time_packed_batch);
+            batch_count = 0;
+        }
     }
 
+    if (batch_count > 0)
+        mismatch_count += compare_batch(batch_words, batch_codes, batch_results,
+                                        batch_count, pattern_judy, &time_batch,
+                                        pattern_packed, &time_packed_batch);
+
     fclose(fp);
     if (line)
         free(line);
     if (word)
         free(word);
 
-    print_results(time_judy, time_trie, word_count);
+    if (alphabet)
+        printf("Keys of patterns and words are transcoded to alphabet of %i characters\n",
+               alphabet->size);
+
+    printf("Hyphenation results\n");
+    print_result("Judy", time_judy, word_count);
+    print_result("cprops Trie", time_trie, word_count);
+    if (pattern_packed)
+        print_result("Packed trie", time_packed, word_count);
+    if (pattern_judy_trie)
+        print_result("Judy trie", time_judy_trie, word_count);
+    if (!alphabet)
+    {
+        printf("Batches of %i words hyphenated with interleaved lookups\n", batch_size);
+        print_result("Judy", time_batch, word_count);
+        if (pattern_packed)
+            print_result("Packed trie", time_packed_batch, word_count);
+    }
+
+    if (incremental && !alphabet)
+    {
+        printf("Incremental hyphenation reused %li of %li matches of previous words\n",
+               incremental_state.reused_count, incremental_state.match_total);
+        print_result("Judy", time_incremental, word_count);
+    }
+
+    if (mismatch_count > 0)
+        printf("Batched hyphenation differs in %i words\n", mismatch_count);
+
+    if (different_count > 0)
+        printf("Other data structures differ from Judy in %i results\n", different_count);
+
+    judy_incremental_free(&incremental_state);
 }
 
 int main(int argc, char **argv)
@@ -123,11 +759,18 @@ int main(int argc, char **argv)
     bool memory_test_Judy_flag = false;
     bool memory_test_Trie_flag = false;
     bool memory_test_only_patterns_flag = false;
+    bool memory_test_Packed_flag = false;
+    bool memory_test_Judy_trie_flag = false;
+    bool prune_flag = false;
+    char *profile_filepath = NULL;
+    int thread_count = 0;
+    bool alphabet_flag = false;
+    bool huge_pages_flag = false;
     char *patterns_filepath = NULL;
     char *words_filepath = NULL;
     int c;
 
-    while ((c = getopt(argc, argv, "jtpvi")) != -1)
+    while ((c = getopt(argc, argv, "jtpviab:cHJoT:IL:")) != -1)
         switch (c)
         {
         case 'j':
@@ -145,11 +788,54 @@ int main(int argc, char **argv)
         case 'v':
             verbose = true;
             break;
+        case 'a':
+            alphabet_flag = true;
+            break;
+        case 'b':
+            batch_size = atoi(optarg);
+            break;
+        case 'c':
+            memory_test_Packed_flag = true;
+            break;
+        case 'H':
+            huge_pages_flag = true;
+            break;
+        case 'J':
+            memory_test_Judy_trie_flag = true;
+            break;
+        case 'o':
+            prune_flag = true;
+            break;
+        case 'T':
+            thread_count = atoi(optarg);
+            break;
+        case 'I':
+            incremental = true;
+            break;
+        case 'L':
+            profile_filepath = optarg;
+            break;
         default:
             fprintf(stderr, "Unknown option `\\x%x'.\n", optopt);
             return 1;
         }
 
+    if (batch_size < 1)
+        batch_size = 1;
+
+    if (batch_size > MAXBATCHSIZE)
+        batch_size = MAXBATCHSIZE;
+
+    if (thread_count > MAXTHREADCOUNT)
+        thread_count = MAXTHREADCOUNT;
+
+    // Threads share data structures with utf8 keys
+    if (thread_count > 0 && alphabet_flag)
+    {
+        fprintf(stderr, "Concurrent benchmark uses utf8 keys, option -a is ignored\n");
+        alphabet_flag = false;
+    }
+
     if (argc - optind != 2)
     {
         fprintf(stderr, "Missing file paths\n");
@@ -165,6 +851,39 @@ int main(int argc, char **argv)
         return 1;
     }
 
+    // Comparing pattern set before and after pruning
+    if (prune_flag)
+    {
+        compare_pruned(words_filepath, &pattern_list);
+        patterns_free(&pattern_list);
+        return 0;
+    }
+
+    // Comparing packed trie before and after profile guided layout
+    if (profile_filepath)
+    {
+        compare_profiled(words_filepath, profile_filepath, &pattern_list);
+        patterns_free(&pattern_list);
+        return 0;
+    }
+
+    // Transcoding patterns to dense alphabet, if it is possible
+    Alphabet alphabet;
+    Alphabet *used_alphabet = NULL;
+    if (alphabet_flag)
+    {
+        if (alphabet_create(&alphabet, &pattern_list))
+        {
+            fprintf(stderr, "Patterns can not be transcoded, using utf8 keys\n");
+            alphabet_free(&alphabet);
+        }
+        else
+        {
+            alphabet_transcode_patterns(&alphabet, &pattern_list);
+            used_alphabet = &alphabet;
+        }
+    }
+
     // Memory testing
     if (memory_test_only_patterns_flag)
     {
@@ -184,6 +903,18 @@ int main(int argc, char **argv)
         return 0;
     }
 
+    if (memory_test_Packed_flag)
+    {
+        space_test_packed(&pattern_list);
+        return 0;
+    }
+
+    if (memory_test_Judy_trie_flag)
+    {
+        space_test_judy_trie(&pattern_list);
+        return 0;
+    }
+
     // Creating judy data structure
     Pvoid_t pattern_judy = (Pvoid_t)NULL;
 
@@ -194,15 +925,50 @@ int main(int argc, char **argv)
     judy_insert_patterns(&pattern_list, &pattern_judy);
     trie_insert_patterns(&pattern_list, pattern_trie);
 
+    // Packed trie is compiled from utf8 patterns only
+    Packed_trie pattern_packed;
+    Packed_trie *used_packed = NULL;
+    if (!used_alphabet && packed_build(&pattern_list, &pattern_packed, huge_pages_flag) == 0)
+        used_packed = &pattern_packed;
+
+    // Judy character trie is keyed by code points of utf8 patterns too
+    Judy_trie pattern_judy_trie = {NULL, 0};
+    Judy_trie *used_judy_trie = NULL;
+    if (!used_alphabet)
+    {
+        judy_trie_insert_patterns(&pattern_list, &pattern_judy_trie);
+        used_judy_trie = &pattern_judy_trie;
+    }
+
+    // Synchronized cprops trie takes lock of the trie for every operation
+    cp_trie *pattern_trie_sync = NULL;
+    if (thread_count > 0)
+    {
+        pattern_trie_sync = cp_trie_create(0);
+        trie_insert_patterns(&pattern_list, pattern_trie_sync);
+    }
+
     // Comparing how both data structure do in hyphenation
-    if (!time_test_insert_flag)
-        compare(words_filepath, &pattern_judy, pattern_trie);
+    if (thread_count > 0)
+        compare_threads(words_filepath, thread_count, &pattern_judy, pattern_trie,
+                        pattern_trie_sync, used_packed, used_judy_trie);
+    else if (!time_test_insert_flag)
+        compare(words_filepath, &pattern_judy, pattern_trie, used_packed, used_judy_trie,
+                used_alphabet);
 
     // Destroying all data structures and freeing all of its memory
     Word_t freed_count;
     JSLFA(freed_count, pattern_judy);
     cp_trie_destroy(pattern_trie);
+    if (pattern_trie_sync)
+        cp_trie_destroy(pattern_trie_sync);
+    if (used_packed)
+        packed_free(used_packed);
+    if (used_judy_trie)
+        judy_trie_free(used_judy_trie);
     patterns_free(&pattern_list);
+    if (used_alphabet)
+        alphabet_free(used_alphabet);
 
     return 0;
 }
\ No newline at end of file
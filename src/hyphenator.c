@@ -2,7 +2,14 @@
 
 #include "hyphenator.h"
 #include "patterns.h"
+#include "alphabet.h"
 #include "judy.h"
+#include "judytrie.h"
+#include "trie.h"
+#include "backend.h"
+#include "packed.h"
+#include "pipeline.h"
+#include "text.h"
 #include "utils.h"
 
 #include <stdio.h>
@@ -16,22 +23,67 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <locale.h>
 
 // Global constants
-int left_hyphen_min = 2;
-int right_hyphen_min = 2;
+__thread int left_hyphen_min = 2;
+__thread int right_hyphen_min = 2;
 bool verbose = false;
 char hyphenation_char = '-';
+int batch_size = 16;
+int worker_count = -1;
+int max_latency = 10;
+bool incremental = false;
+
+// Batches are kept on stack, so their size is limited
+#define MAXBATCHSIZE 1024
 char usage[] = "\nUsage: hyphenator [options] pattern_file\n"
                "hyphenator program loads hyphenation patterns and then hyphenates words from the file or terminal input\n\n"
                "Options:\n"
-               "\t-h\t\tShow this message"
-               "\t-v\t\tVerbose"
+               "\t-h\t\tShow this message\n"
+               "\t-v\t\tVerbose\n"
+               "\t-a\t\tTranscode patterns and words to dense alphabet of patterns\n"
                "\t-lx\t\tx can be an arbitrary number higher than 0, it sets `left_hyphen_min` for hyphenating process\n"
                "\t-rx\t\tx can be an arbitrary number higher than 0, it sets `right_hyphen_min` for hyphenating process\n"
-               "\t-f file_name\tspecifies a file with words to be hyphenated, if not specified, words from terminal will be hyphenated\n";
+               "\t-f file_name\tspecifies a file with words to be hyphenated, if not specified, words from terminal will be hyphenated\n"
+               "\t-P\t\tUse packed trie compiled from patterns instead of Judy\n"
+               "\t-H\t\tPlace packed trie in huge pages, if they are available\n"
+               "\t-N\t\tReplicate packed trie to every NUMA node\n"
+               "\t-J\t\tUse Judy character trie keyed by node and code point instead of JudySL\n"
+               "\t-I\t\tReuse Judy matches of the previous word inside of shared prefix, fast for sorted words\n"
+               "\t-bx\t\tx words from file or text are hyphenated together with interleaved lookups, 1 disables batching (default 16)\n"
+               "\t-wx\t\tx worker threads hyphenate terminal input in pipeline, 0 disables pipeline (default count of CPUs - 1)\n"
+               "\t-Lx\t\tNot full batch of terminal input is hyphenated after x milliseconds (default 10)\n"
+               "\t-t\t\tHyphenate running text instead of one word per line, words are found in the text and case is kept\n"
+               "\t-S\t\tInsert soft hyphen U+00AD in text mode instead of hyphenation character\n"
+               "\t--max-mem x\tChoose the fastest backend which needs at most x bytes, suffixes K, M and G can be used\n"
+               "\t--max-latency x\tChoose the fastest backend which hyphenates word in at most x microseconds\n";
 
-bool command_parser(const char *word, int read)
+// Values of long options without short form
+enum
+{
+    OPTION_MAX_MEM = 256,
+    OPTION_MAX_LATENCY
+};
+
+static const struct option long_options[] = {
+    {"max-mem", required_argument, NULL, OPTION_MAX_MEM},
+    {"max-latency", required_argument, NULL, OPTION_MAX_LATENCY},
+    {NULL, 0, NULL, 0},
+};
+
+// Data structures used for hyphenation of one line
+typedef struct
+{
+    Pvoid_t *pattern_judy;
+    Packed_set *packed;
+    Judy_trie *judy_trie;
+    cp_trie *trie;
+    Alphabet *alphabet;
+} Hyphenator_context;
+
+bool command_apply(const char *word, int read)
 {
     if (read < 2)
         return false;
@@ -46,7 +98,6 @@ bool command_parser(const char *word, int read)
         left_hyphen_min = atoi(&word[2]);
         if (left_hyphen_min == 0)
             left_hyphen_min = 2;
-        printf("left_hyphen_min has been changed to: %i\n", left_hyphen_min);
     }
 
     // Change right_hyphen_min value
@@ -55,13 +106,104 @@ bool command_parser(const char *word, int read)
         right_hyphen_min = atoi(&word[2]);
         if (right_hyphen_min == 0)
             right_hyphen_min = 2;
-        printf("right_hyphen_min has been changed to: %i\n", right_hyphen_min);
     }
 
     return false;
 }
 
-void hyphenator(const char *file_name, Pvoid_t *pattern_judy)
+void command_report(const char *word, int read)
+{
+    if (read < 2)
+        return;
+
+    if (word[1] == 'l')
+        printf("left_hyphen_min has been changed to: %i\n", left_hyphen_min);
+
+    if (word[1] == 'r')
+        printf("right_hyphen_min has been changed to: %i\n", right_hyphen_min);
+}
+
+bool command_parser(const char *word, int read)
+{
+    if (command_apply(word, read))
+        return true;
+
+    command_report(word, read);
+    return false;
+}
+
+/**
+ * Private hyphenator.c function which hyphenates one line with data structure
+ * from context. It is also called from pipeline workers, so it only reads
+ * shared data. Returns pointer to allocated string with hyphenation characters.
+ */
+static char *hyphenate_line(char *line, int read, void *context)
+{
+    Hyphenator_context *structures = context;
+    char *word = add_dots_to_word(read, line);
+    char *result;
+
+    if (structures->packed)
+    {
+        char *utf8_code = create_utf_array(word);
+        result = packed_hyphenate(word, packed_local(structures->packed), utf8_code);
+        free(utf8_code);
+    }
+    else if (structures->judy_trie)
+    {
+        char *utf8_code = create_utf_array(word);
+        result = judy_trie_hyphenate(word, structures->judy_trie, utf8_code);
+        free(utf8_code);
+    }
+    else if (structures->trie)
+    {
+        char *utf8_code = create_utf_array(word);
+        result = trie_hyphenate(word, structures->trie, utf8_code);
+        free(utf8_code);
+    }
+    else if (structures->alphabet)
+    {
+        unsigned char symbols[read + 3];
+        int symbol_count = alphabet_transcode(structures->alphabet, word, symbols);
+        result = judy_hyphenate_symbols(word, symbols, symbol_count, structures->pattern_judy);
+    }
+    else
+    {
+        char *utf8_code = create_utf_array(word);
+        result = judy_hyphenate(word, structures->pattern_judy, utf8_code);
+        free(utf8_code);
+    }
+
+    free(word);
+    return result;
+}
+
+// Private hyphenator.c function which hyphenates and outputs loaded batch
+static void hyphenator_flush(char **words, char **utf8_codes, char **results,
+                             int count, Hyphenator_context *structures)
+{
+    const Packed_trie *trie = structures->packed ? packed_local(structures->packed) : NULL;
+
+    if (trie && trie->size >= PACKED_BATCH_MIN_SIZE)
+        packed_hyphenate_batch(words, utf8_codes, count, trie, results);
+    else if (trie)
+        for (int i = 0; i < count; i++)
+            results[i] = packed_hyphenate(words[i], trie, utf8_codes[i]);
+    else
+        judy_hyphenate_batch(words, utf8_codes, count, structures->pattern_judy, results);
+
+    for (int i = 0; i < count; i++)
+    {
+        if (results[i])
+            printf("%s\n", results[i]);
+        free(results[i]);
+        free(utf8_codes[i]);
+        free(words[i]);
+    }
+}
+
+void hyphenator(const char *file_name, Pvoid_t *pattern_judy, Packed_set *packed,
+                Judy_trie *judy_trie, cp_trie *trie, Alphabet *alphabet)
 {
     FILE *fp;
     char *line = NULL;
@@ -70,6 +212,21 @@ void hyphenator(const char *file_name, Pvoid_t *pattern_judy)
 
     char *word = NULL;
 
+    // Words from file are hyphenated in batches, terminal input word by word
+    bool batched = file_name != NULL && alphabet == NULL &&
+                   judy_trie == NULL && trie == NULL && !incremental && batch_size > 1;
+    char *batch_words[batched ? batch_size : 1];
+    char *batch_codes[batched ? batch_size : 1];
+    char *batch_results[batched ? batch_size : 1];
+    int batch_count = 0;
+
+    Hyphenator_context context = {pattern_judy, packed, judy_trie, trie, alphabet};
+
+    // Incremental hyphenation needs words in their order, so it is not used in pipeline
+    Judy_incremental incremental_state = {0};
+    bool incremental_used = incremental && alphabet == NULL && packed == NULL &&
+                            judy_trie == NULL && trie == NULL;
+
     if (file_name != NULL)
     {
         fp = fopen(file_name, "r");
@@ -78,6 +235,15 @@ void hyphenator(const char *file_name, Pvoid_t *pattern_judy)
     {
         printf("Write words to be hyphenated:\n");
         fp = stdin;
+
+        // Terminal input is read, hyphenated and written by separate threads
+        if (worker_count > 0 && !verbose && !incremental_used)
+        {
+            fflush(stdout);
+            pipeline_run(STDIN_FILENO, hyphenate_line, &context, worker_count, batch_size,
+                         max_latency);
+            return;
+        }
     }
 
     if (fp == NULL)
@@ -102,26 +268,83 @@ void hyphenator(const char *file_name, Pvoid_t *pattern_judy)
         // commands from command line
         if (line[0] == ':')
         {
+            // Words before command are hyphenated with previous settings
+            if (batch_count > 0)
+                hyphenator_flush(batch_words, batch_codes, batch_results, batch_count, &context);
+            batch_count = 0;
+
             if (command_parser(line, read))
                 break;
 
             continue;
         }
 
-        word = add_dots_to_word(read, line);
-        char *utf8_code = create_utf_array(word);
-        char *judy_hyphenated = judy_hyphenate(word, pattern_judy, utf8_code);
+        if (batched)
+        {
+            word = add_dots_to_word(read, line);
+            batch_words[batch_count] = word;
+            batch_codes[batch_count] = create_utf_array(word);
+            word = NULL;
 
+            if (++batch_count == batch_size)
+            {
+                hyphenator_flush(batch_words, batch_codes, batch_results, batch_count, &context);
+                batch_count = 0;
+            }
+            continue;
+        }
+
+        char *judy_hyphenated;
+        if (incremental_used)
+        {
+            word = add_dots_to_word(read, line);
+            char *utf8_code = create_utf_array(word);
+            judy_hyphenated = judy_hyphenate_incremental(word, pattern_judy, utf8_code,
+                                                         &incremental_state);
+            free(utf8_code);
+            free(word);
+            word = NULL;
+        }
+        else
+            judy_hyphenated = hyphenate_line(line, read, &context);
         printf("%s\n", judy_hyphenated);
         free(judy_hyphenated);
-        free(utf8_code);
     }
 
+    if (batch_count > 0)
+        hyphenator_flush(batch_words, batch_codes, batch_results, batch_count, &context);
+
     fclose(fp);
     if (line)
         free(line);
     if (word)
         free(word);
+    judy_incremental_free(&incremental_state);
+}
+
+// Private hyphenator.c function which parses size in bytes with optional K, M or G suffix
+static size_t parse_size(const char *text)
+{
+    char *end;
+    double size = strtod(text, &end);
+
+    switch (*end)
+    {
+    case 'G':
+    case 'g':
+        size *= 1024;
+        /* fall through */
+    case 'M':
+    case 'm':
+        size *= 1024;
+        /* fall through */
+    case 'K':
+    case 'k':
+        size *= 1024;
+        break;
+    }
+
+    return size > 0 ? (size_t)size : 0;
 }
 
 int main(int argc, char **argv)
@@ -131,9 +354,19 @@ int main(int argc, char **argv)
 
     char *patterns_filepath = NULL;
     char *words_filepath = NULL;
+    bool alphabet_flag = false;
+    bool packed_flag = false;
+    bool huge_pages_flag = false;
+    bool numa_flag = false;
+    bool judy_trie_flag = false;
+    bool text_flag = false;
+    bool soft_hyphen_flag = false;
+    bool trie_flag = false;
+    size_t max_memory = 0;
+    double max_word_usec = 0;
 
     int c;
-    while ((c = getopt(argc, argv, "hvl:r:f:")) != -1)
+    while ((c = getopt_long(argc, argv, "hval:r:f:b:PHNJIw:L:tS", long_options, NULL)) != -1)
         switch (c)
         {
         case 'h':
@@ -148,9 +381,48 @@ int main(int argc, char **argv)
         case 'v':
             verbose = true;
             break;
+        case 'a':
+            alphabet_flag = true;
+            break;
         case 'f':
             words_filepath = optarg;
             break;
+        case 'b':
+            batch_size = atoi(optarg);
+            break;
+        case 'P':
+            packed_flag = true;
+            break;
+        case 'H':
+            huge_pages_flag = true;
+            break;
+        case 'N':
+            numa_flag = true;
+            break;
+        case 'J':
+            judy_trie_flag = true;
+            break;
+        case 'I':
+            incremental = true;
+            break;
+        case 'w':
+            worker_count = atoi(optarg);
+            break;
+        case 'L':
+            max_latency = atoi(optarg);
+            break;
+        case 't':
+            text_flag = true;
+            break;
+        case 'S':
+            soft_hyphen_flag = true;
+            break;
+        case OPTION_MAX_MEM:
+            max_memory = parse_size(optarg);
+            break;
+        case OPTION_MAX_LATENCY:
+            max_word_usec = atof(optarg);
+            break;
         default:
             fprintf(stderr, "Unknown option `\\x%x'.\n", optopt);
             return 1;
@@ -162,6 +434,23 @@ int main(int argc, char **argv)
     if (right_hyphen_min < 1)
         right_hyphen_min = 1;
 
+    if (batch_size > MAXBATCHSIZE)
+        batch_size = MAXBATCHSIZE;
+
+    if (batch_size < 1)
+        batch_size = 1;
+
+    // One CPU is left for reader and writer
+    if (worker_count < 0)
+    {
+        worker_count = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+        if (worker_count < 1)
+            worker_count = 1;
+    }
+
+    if (max_latency < 0)
+        max_latency = 0;
+
     if (argc - optind != 1)
     {
         fprintf(stderr, "Missing file paths\n");
@@ -169,20 +458,156 @@ int main(int argc, char **argv)
     }
     patterns_filepath = argv[optind];
 
+    // Text mode always looks words up in JudySL, transcoded to alphabet if it is possible
+    if (text_flag)
+    {
+        if (packed_flag || judy_trie_flag || incremental)
+            fprintf(stderr, "Text mode uses JudySL, options -P, -J and -I are ignored\n");
+
+        packed_flag = false;
+        judy_trie_flag = false;
+        alphabet_flag = true;
+
+        // Case of non ASCII letters is folded by the locale
+        if (setlocale(LC_CTYPE, "C.UTF-8") == NULL)
+            setlocale(LC_CTYPE, "");
+    }
+    else if (soft_hyphen_flag)
+        fprintf(stderr, "Soft hyphen is used only in text mode, option -S is ignored\n");
+
+    if (text_flag && (max_memory || max_word_usec > 0))
+    {
+        fprintf(stderr, "Text mode uses JudySL, options --max-mem and --max-latency are ignored\n");
+        max_memory = 0;
+        max_word_usec = 0;
+    }
+
     // Load patterns
     Pattern_wrapper pattern_list;
     patterns_load(&pattern_list, patterns_filepath);
 
-    // Creating judy data structure and inserting patterns
+    // Every backend is measured with the patterns and the fastest one within limits is used
+    if (max_memory || max_word_usec > 0)
+    {
+        if (packed_flag || judy_trie_flag)
+            fprintf(stderr, "Backend is chosen by limits, options -P and -J are ignored\n");
+
+        Backend_measure measures[BACKEND_COUNT];
+        int chosen = backend_select(&pattern_list, words_filepath, max_memory, max_word_usec,
+                                    measures);
+        // Figures of measures are valid only for measured backends
+        if (chosen == -1)
+        {
+            fprintf(stderr, "Backends could not be measured, Judy is used\n");
+            chosen = BACKEND_JUDY;
+        }
+
+        if (verbose)
+        {
+            printf("%-10s %14s %14s %12s\n", "Backend", "Estimate", "Bytes", "Usec/word");
+            for (int b = 0; b < BACKEND_COUNT; b++)
+                if (measures[b].measured)
+                    printf("%-10s %14zu %14zu %12.3f\n", backends[b].name, measures[b].estimate,
+                           measures[b].bytes, measures[b].usec_per_word);
+                else
+                    printf("%-10s %14zu %14s %12s\n", backends[b].name, measures[b].estimate,
+                           "-", "-");
+            printf("Backend %s was chosen for memory budget %zu bytes and latency goal %.3f "
+                   "microseconds (0 is no limit)\n",
+                   backends[chosen].name, max_memory, max_word_usec);
+        }
+
+        packed_flag = chosen == BACKEND_PACKED;
+        judy_trie_flag = chosen == BACKEND_JUDY_TRIE;
+        trie_flag = chosen == BACKEND_TRIE;
+    }
+
+    // Transcoding patterns to dense alphabet, if it is possible
+    Alphabet alphabet;
+    Alphabet *used_alphabet = NULL;
+    if (alphabet_flag && packed_flag)
+        fprintf(stderr, "Packed trie uses utf8 keys, option -a is ignored\n");
+    else if (alphabet_flag && judy_trie_flag)
+        fprintf(stderr, "Judy character trie uses code points, option -a is ignored\n");
+    else if (alphabet_flag && trie_flag)
+        fprintf(stderr, "Cprops trie is used with utf8 keys, option -a is ignored\n");
+
+    if (alphabet_flag && !packed_flag && !judy_trie_flag && !trie_flag)
+    {
+        if (alphabet_create(&alphabet, &pattern_list))
+        {
+            fprintf(stderr, "Patterns can not be transcoded, using utf8 keys\n");
+            alphabet_free(&alphabet);
+        }
+        else
+        {
+            alphabet_transcode_patterns(&alphabet, &pattern_list);
+            used_alphabet = &alphabet;
+        }
+    }
+
+    // Creating judy data structure and inserting patterns or packed trie
     Pvoid_t pattern_judy = (Pvoid_t)NULL;
-    judy_insert_patterns(&pattern_list, &pattern_judy);
+    Packed_set pattern_packed;
+    Packed_set *used_packed = NULL;
+    Judy_trie pattern_judy_trie = {NULL, 0};
+    Judy_trie *used_judy_trie = NULL;
+    cp_trie *used_trie = NULL;
+    if (packed_flag)
+    {
+        if (packed_set_create(&pattern_packed, &pattern_list, huge_pages_flag, numa_flag))
+        {
+            packed_set_free(&pattern_packed);
+            patterns_free(&pattern_list);
+            return 1;
+        }
+        used_packed = &pattern_packed;
+    }
+    else if (judy_trie_flag)
+    {
+        judy_trie_insert_patterns(&pattern_list, &pattern_judy_trie);
+        used_judy_trie = &pattern_judy_trie;
+    }
+    else if (trie_flag)
+    {
+        used_trie = cp_trie_create(COLLECTION_MODE_NOSYNC);
+        trie_insert_patterns(&pattern_list, used_trie);
+    }
+    else
+        judy_insert_patterns(&pattern_list, &pattern_judy);
 
-    hyphenator(words_filepath, &pattern_judy);
+    int result = 0;
+    if (text_flag)
+    {
+        int fd = words_filepath ? open(words_filepath, O_RDONLY) : STDIN_FILENO;
+        if (fd < 0)
+        {
+            printf("Cannot open file %s\n", words_filepath);
+            result = 1;
+        }
+        else
+        {
+            result = text_hyphenate(fd, &pattern_judy, used_alphabet, soft_hyphen_flag);
+            if (words_filepath)
+                close(fd);
+        }
+    }
+    else
+        hyphenator(words_filepath, &pattern_judy, used_packed, used_judy_trie, used_trie,
+                   used_alphabet);
 
     // Destroying all data structures and freeing all of its memory
     Word_t freed_count;
     JSLFA(freed_count, pattern_judy);
+    if (used_packed)
+        packed_set_free(used_packed);
+    if (used_judy_trie)
+        judy_trie_free(used_judy_trie);
+    if (used_trie)
+        cp_trie_destroy(used_trie);
     patterns_free(&pattern_list);
+    if (used_alphabet)
+        alphabet_free(used_alphabet);
 
-    return 0;
+    return result;
 }
\ No newline at end of file
@@ -2,14 +2,36 @@
 #include "patterns.h"
 #include "utils.h"
 
+#include <stdio.h>
 #include <stdbool.h>
 
 // Necessary Judy settings
 #define JUDYERROR_SAMPLE 1 // use default Judy error handler
-#define MAXLINELEN 20      // define maximum pattern length
 
 extern bool verbose;
 
+// Size of the longest inserted pattern with null, prefix search copies keys into buffer of this size
+static size_t judy_key_size = 1;
+
+/**
+ * State of one word in judy_hyphenate_batch. Substring with length i starting
+ * at character j is searched next, lengths grow until no pattern can start
+ * with the substring, then the next start is used. Pending_code is the last found pattern
+ * code, which is merged at pending_position in the next round.
+ */
+typedef struct
+{
+    char *word;
+    const char *utf8_code;
+    char *hyph_code;
+    int len;
+    int i;
+    int j;
+    const char *pending_code;
+    int pending_position;
+    int pending_len;
+} Judy_lookup;
+
 void judy_insert_patterns(Pattern_wrapper *patterns, Pvoid_t *judy_array)
 {
     Word_t *PValue;
@@ -17,6 +39,10 @@ void judy_insert_patterns(Pattern_wrapper *patterns, Pvoid_t *judy_array)
     STARTTm;
     for (int i = 0; i < patterns->count; i++)
     {
+        size_t key_size = strlen(patterns->patterns[i].word) + 1;
+        if (key_size > judy_key_size)
+            judy_key_size = key_size;
+
         JSLI(PValue, *judy_array, (uint8_t *)patterns->patterns[i].word);
         *PValue = (long unsigned int)patterns->patterns[i].code;
     }
@@ -28,55 +54,374 @@ void judy_insert_patterns(Pattern_wrapper *patterns, Pvoid_t *judy_array)
                patterns->count, DeltaUSec, DeltaUSec / patterns->count);
 }
 
-char *judy_hyphenate(char *word, Pvoid_t *pattern_judy, const char *utf8_code)
+/**
+ * Private judy.c function which searches key of key_len bytes with JSLF, so
+ * it also finds out if any pattern starts with key. Returns pointer to pattern
+ * code if key is pattern or NULL and sets extendable to false if longer keys
+ * can not be patterns.
+ */
+static Word_t *judy_prefix_search(Pvoid_t pattern_judy, const uint8_t *key, int key_len,
+                                  bool *extendable)
 {
-    char backup;
-    int len = strlen_utf8(word);
+    Word_t *find_return = NULL;
+
+    // No pattern is that long
+    if (key_len < 0 || (size_t)key_len >= judy_key_size)
+    {
+        *extendable = false;
+        return NULL;
+    }
 
-    char hyph_code[len + 1];
-    memset(hyph_code, 0, (len + 1) * sizeof(char));
+    uint8_t index[judy_key_size];
+    memcpy(index, key, key_len);
+    index[key_len] = '\0';
+
+    // First pattern which is not lower than key must start with key
+    JSLF(find_return, pattern_judy, index);
+    if (find_return == NULL || memcmp(index, key, key_len) != 0)
+    {
+        *extendable = false;
+        return NULL;
+    }
+
+    *extendable = true;
+    return index[key_len] == '\0' ? find_return : NULL;
+}
+
+int judy_code(char *word, int len, Pvoid_t *pattern_judy, const char *utf8_code,
+              char *hyph_code)
+{
     const char *pattern_code = NULL;
     Word_t *find_return = NULL;
+    int lookup_count = 0;
+
+    for (int j = 0; j < len; j++)
+    {
+        const uint8_t *key = (uint8_t *)&word[(int)utf8_code[j]];
+        bool extendable = true;
+
+        // Substrings starting at j are extended while some pattern starts with them
+        for (int i = 1; i <= len - j && extendable; i++)
+        {
+            int key_len = utf8_code[j + i] - utf8_code[j];
+
+            find_return = judy_prefix_search(*pattern_judy, key, key_len, &extendable);
+            lookup_count++;
+
+            if (find_return != NULL)
+            {
+                if (verbose)
+                    printf("Subword '%.*s'\t\t was found - pattern code: ", key_len, key);
+
+                pattern_code = (char *)*find_return;
+
+                if (verbose)
+                {
+                    for (int k = 0; k <= i; k++)
+                        printf("%i", pattern_code[k]);
+                    putchar('\n');
+                }
+
+                code_merge(&hyph_code[j], pattern_code, i);
+            }
+        }
+    }
+
+    return lookup_count;
+}
+
+char *judy_hyphenate(char *word, Pvoid_t *pattern_judy, const char *utf8_code)
+{
+    int len = strlen_utf8(word);
+
+    char hyph_code[HYPH_CODE_SIZE(len)];
+    memset(hyph_code, 0, sizeof(hyph_code));
 
     if (verbose)
         printf("Hyphenating word '%s' with Judy:\n", word);
 
-    for (int i = 1; i <= len; i++)
+    int lookup_count = judy_code(word, len, pattern_judy, utf8_code, hyph_code);
+
+    char *result = hyphenate_from_code(word, hyph_code);
+    if (verbose)
+        printf("Hyphenation result: '%s' after %i lookups\n\n", result, lookup_count);
+
+    return result;
+}
+
+// Private judy.c function which merges pending pattern code of lookup
+static void judy_lookup_merge(Judy_lookup *lookup)
+{
+    code_merge(&lookup->hyph_code[lookup->pending_position], lookup->pending_code,
+               lookup->pending_len);
+    lookup->pending_code = NULL;
+}
+
+void judy_code_batch(char **keys, char **utf8_codes, const int *lens, int count,
+                     Pvoid_t *pattern_judy, char **hyph_codes)
+{
+    Judy_lookup lookups[count];
+
+    for (int w = 0; w < count; w++)
+    {
+        lookups[w].word = keys[w];
+        lookups[w].utf8_code = utf8_codes[w];
+        lookups[w].hyph_code = hyph_codes[w];
+        lookups[w].len = lens[w];
+        lookups[w].i = 1;
+        lookups[w].j = 0;
+        lookups[w].pending_code = NULL;
+    }
+
+    // Words which are still searched are kept at the beginning of lookups
+    int active = count;
+    bool extendable;
+    Word_t *find_return = NULL;
+
+    while (active > 0)
     {
-        for (int j = 0; j <= len - i; j++)
+        for (int w = 0; w < active; w++)
         {
-            backup = word[(int)utf8_code[j + i]];
-            word[(int)utf8_code[j + i]] = '\0';
+            Judy_lookup *lookup = &lookups[w];
+            const char *utf8_code = lookup->utf8_code;
+            char *word = lookup->word;
+
+            // Code of the previous hit had the whole round to arrive in cache
+            if (lookup->pending_code)
+                judy_lookup_merge(lookup);
+
+            // Finished word is replaced by the last active one
+            if (lookup->j >= lookup->len)
+            {
+                *lookup = lookups[--active];
+                w--;
+                continue;
+            }
+
+            find_return = judy_prefix_search(*pattern_judy,
+                                             (uint8_t *)&word[(int)utf8_code[lookup->j]],
+                                             utf8_code[lookup->j + lookup->i] - utf8_code[lookup->j],
+                                             &extendable);
+
+            if (find_return != NULL)
+            {
+                lookup->pending_code = (const char *)*find_return;
+                lookup->pending_position = lookup->j;
+                lookup->pending_len = lookup->i;
+                __builtin_prefetch(lookup->pending_code);
+            }
+
+            // Longer substring from the same start or the next start
+            if (extendable && lookup->j + lookup->i < lookup->len)
+                lookup->i++;
+            else
+            {
+                lookup->j++;
+                lookup->i = 1;
+            }
+        }
+    }
+}
+
+void judy_hyphenate_batch(char **words, char **utf8_codes, int count,
+                          Pvoid_t *pattern_judy, char **results)
+{
+    int lens[count];
+    char *word_codes[count];
+    int code_size = 0;
+
+    for (int w = 0; w < count; w++)
+    {
+        lens[w] = strlen_utf8(words[w]);
+        code_size += HYPH_CODE_SIZE(lens[w]);
+    }
+
+    char *hyph_codes = calloc(code_size, sizeof(char));
+    if (hyph_codes == NULL)
+    {
+        printf("Allocation error\n");
+        for (int w = 0; w < count; w++)
+            results[w] = NULL;
+        return;
+    }
+
+    code_size = 0;
+    for (int w = 0; w < count; w++)
+    {
+        word_codes[w] = &hyph_codes[code_size];
+        code_size += HYPH_CODE_SIZE(lens[w]);
+    }
+
+    judy_code_batch(words, utf8_codes, lens, count, pattern_judy, word_codes);
+
+    for (int w = 0; w < count; w++)
+    {
+        results[w] = hyphenate_from_code(words[w], word_codes[w]);
+
+        if (verbose)
+            printf("Hyphenation result of '%s' in batch: '%s'\n", words[w], results[w]);
+    }
+
+    free(hyph_codes);
+}
+
+void judy_code_symbols(const unsigned char *symbols, int len, Pvoid_t *pattern_judy,
+                       char *hyph_code)
+{
+    const char *pattern_code = NULL;
+    Word_t *find_return = NULL;
+
+    for (int j = 0; j < len; j++)
+    {
+        bool extendable = true;
 
-            JSLG(find_return, *pattern_judy, (uint8_t *)&word[(int)utf8_code[j]]);
+        for (int i = 1; i <= len - j && extendable; i++)
+        {
+            find_return = judy_prefix_search(*pattern_judy, &symbols[j], i, &extendable);
 
             if (find_return != NULL)
             {
                 if (verbose)
-                    printf("Subword '%s'\t\t was found - pattern code: ", &word[(int)utf8_code[j]]);
+                    printf("Subword at %i of length %i was found - pattern code: ", j, i);
 
                 pattern_code = (char *)*find_return;
 
-                for (int k = 0; k <= i; k++)
+                if (verbose)
                 {
-                    if (verbose)
+                    for (int k = 0; k <= i; k++)
                         printf("%i", pattern_code[k]);
-
-                    if (pattern_code[k] > hyph_code[j + k])
-                        hyph_code[j + k] = pattern_code[k];
+                    putchar('\n');
                 }
 
+                code_merge(&hyph_code[j], pattern_code, i);
+            }
+        }
+    }
+}
+
+char *judy_hyphenate_symbols(char *word, unsigned char *symbols, int len,
+                             Pvoid_t *pattern_judy)
+{
+    char hyph_code[HYPH_CODE_SIZE(len)];
+    memset(hyph_code, 0, sizeof(hyph_code));
+
+    if (verbose)
+        printf("Hyphenating word '%s' with Judy and alphabet:\n", word);
+
+    judy_code_symbols(symbols, len, pattern_judy, hyph_code);
+
+    char *result = hyphenate_from_code(word, hyph_code);
+    if (verbose)
+        printf("Hyphenation result: '%s'\n\n", result);
+
+    return result;
+}
+
+// Private judy.c function which adds match to incremental state
+static void judy_incremental_add(Judy_incremental *state, const char *code, int position,
+                                 int len)
+{
+    if (state->match_count == state->match_allocated)
+    {
+        state->match_allocated = state->match_allocated ? state->match_allocated * 2 : 64;
+        state->matches = realloc(state->matches, state->match_allocated * sizeof(Judy_match));
+        if (state->matches == NULL)
+        {
+            printf("Allocation error\n");
+            exit(1);
+        }
+    }
+
+    state->matches[state->match_count++] = (Judy_match){code, position, len};
+}
+
+char *judy_hyphenate_incremental(char *word, Pvoid_t *pattern_judy, const char *utf8_code,
+                                 Judy_incremental *state)
+{
+    int byte_len = strlen(word);
+    if (byte_len > JUDY_MAXWORDBYTES)
+        return judy_hyphenate(word, pattern_judy, utf8_code);
+
+    int len = strlen_utf8(word);
+    char hyph_code[HYPH_CODE_SIZE(len)];
+    memset(hyph_code, 0, sizeof(hyph_code));
+    Word_t *find_return = NULL;
+    int lookup_count = 0;
+
+    // Characters shared with the previous word, they have the same offsets
+    int common = 0;
+    if (state->word)
+        while (common < byte_len && word[common] == state->word[common])
+            common++;
+
+    int shared = 0;
+    while (shared < len && utf8_code[shared + 1] <= common)
+        shared++;
+
+    // Matches which lie inside of shared prefix are found again in word
+    int kept_count = 0;
+    for (int m = 0; m < state->match_count; m++)
+        if (state->matches[m].position + state->matches[m].len <= shared)
+            state->matches[kept_count++] = state->matches[m];
+    state->match_count = kept_count;
+
+    if (verbose)
+        printf("Hyphenating word '%s' with Judy incrementally, %i characters are shared "
+               "and %i matches reused:\n", word, shared, kept_count);
+
+    for (int j = 0; j < len; j++)
+    {
+        const uint8_t *key = (uint8_t *)&word[(int)utf8_code[j]];
+        bool extendable = true;
+
+        // Only substrings which reach behind shared prefix are searched
+        for (int i = shared > j ? shared - j + 1 : 1; i <= len - j && extendable; i++)
+        {
+            int key_len = utf8_code[j + i] - utf8_code[j];
+
+            find_return = judy_prefix_search(*pattern_judy, key, key_len, &extendable);
+            lookup_count++;
+
+            if (find_return != NULL)
+            {
                 if (verbose)
-                    putchar('\n');
+                    printf("Subword '%.*s'\t\t was found\n", key_len, key);
+
+                judy_incremental_add(state, (const char *)*find_return, j, i);
             }
+        }
+    }
+
+    for (int m = 0; m < state->match_count; m++)
+        code_merge(&hyph_code[state->matches[m].position], state->matches[m].code,
+                   state->matches[m].len);
+
+    state->reused_count += kept_count;
+    state->match_total += state->match_count;
 
-            word[(int)utf8_code[j + i]] = backup;
+    // Word is kept for the next call
+    if (byte_len + 1 > state->word_allocated)
+    {
+        state->word_allocated = byte_len + 1;
+        state->word = realloc(state->word, state->word_allocated);
+        if (state->word == NULL)
+        {
+            printf("Allocation error\n");
+            exit(1);
         }
     }
+    memcpy(state->word, word, byte_len + 1);
 
     char *result = hyphenate_from_code(word, hyph_code);
     if (verbose)
-        printf("Hyphenation result: '%s'\n\n", result);
+        printf("Hyphenation result: '%s' after %i lookups\n\n", result, lookup_count);
 
     return result;
-}
\ No newline at end of file
+}
+
+void judy_incremental_free(Judy_incremental *state)
+{
+    free(state->word);
+    free(state->matches);
+    memset(state, 0, sizeof(Judy_incremental));
+}
@@ -0,0 +1,117 @@
+#include "judytrie.h"
+#include "patterns.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// Necessary Judy settings
+#define JUDYERROR_SAMPLE 1 // use default Judy error handler
+
+extern bool verbose;
+
+// Private judytrie.c function which returns JudyL index of edge or of code
+static inline Word_t judy_trie_index(Word_t node, int code_point)
+{
+    return (node << JUDY_TRIE_CHAR_BITS) | (Word_t)code_point;
+}
+
+void judy_trie_insert_patterns(Pattern_wrapper *patterns, Judy_trie *trie)
+{
+    Word_t *PValue;
+
+    STARTTm;
+    for (int i = 0; i < patterns->count; i++)
+    {
+        const char *key = patterns->patterns[i].word;
+        Word_t node = 0;
+
+        while (*key)
+        {
+            int code_point;
+            key += utf8_decode(key, &code_point);
+
+            // New edge gets value 0, so the next id is assigned to it
+            JLI(PValue, trie->array, judy_trie_index(node, code_point));
+            if (*PValue == 0)
+                *PValue = ++trie->node_count;
+            node = *PValue;
+        }
+
+        // Same as in JudySL, the last of duplicate patterns is used
+        JLI(PValue, trie->array, judy_trie_index(node, 0));
+        *PValue = (Word_t)patterns->patterns[i].code;
+    }
+    ENDTm;
+
+    if (verbose)
+        printf("Insertion in Judy character trie   of %u patterns "
+               "took %8.f microseconds (%.3f per pattern)\n",
+               patterns->count, DeltaUSec, DeltaUSec / patterns->count);
+}
+
+char *judy_trie_hyphenate(char *word, Judy_trie *trie, const char *utf8_code)
+{
+    int len = strlen_utf8(word);
+
+    char hyph_code[HYPH_CODE_SIZE(len)];
+    memset(hyph_code, 0, sizeof(hyph_code));
+    Word_t *PValue;
+    int lookup_count = 0;
+
+    // Every character is decoded only once, not for every substring
+    int code_points[len];
+    for (int i = 0; i < len; i++)
+        utf8_decode(&word[(int)utf8_code[i]], &code_points[i]);
+
+    if (verbose)
+        printf("Hyphenating word '%s' with Judy character trie:\n", word);
+
+    for (int j = 0; j < len; j++)
+    {
+        Word_t node = 0;
+
+        for (int i = j; i < len; i++)
+        {
+            JLG(PValue, trie->array, judy_trie_index(node, code_points[i]));
+            lookup_count++;
+            if (PValue == NULL)
+                break;
+            node = *PValue;
+
+            JLG(PValue, trie->array, judy_trie_index(node, 0));
+            lookup_count++;
+            if (PValue == NULL)
+                continue;
+
+            const char *pattern_code = (const char *)*PValue;
+
+            if (verbose)
+                printf("Subword at %i of length %i was found - pattern code: ", j, i - j + 1);
+
+            if (verbose)
+            {
+                for (int k = 0; k <= i - j + 1; k++)
+                    printf("%i", pattern_code[k]);
+                putchar('\n');
+            }
+
+            code_merge(&hyph_code[j], pattern_code, i - j + 1);
+        }
+    }
+
+    char *result = hyphenate_from_code(word, hyph_code);
+    if (verbose)
+        printf("Hyphenation result: '%s' after %i lookups\n\n", result, lookup_count);
+
+    return result;
+}
+
+Word_t judy_trie_free(Judy_trie *trie)
+{
+    Word_t freed_count;
+    JLFA(freed_count, trie->array);
+    trie->node_count = 0;
+
+    return freed_count;
+}
@@ -0,0 +1,103 @@
+#define _GNU_SOURCE
+
+#include "patterns.h"
+#include "judy.h"
+#include "prune.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <assert.h>
+
+// Global constants
+__thread int left_hyphen_min = 2;
+__thread int right_hyphen_min = 2;
+bool verbose = false;
+char hyphenation_char = '-';
+char usage[] = "\nUsage: optimize [options] pattern_file word_file\n"
+               "optimize program removes duplicate and dominated patterns and verifies, that words are hyphenated the same way\n\n"
+               "Options:\n"
+               "\t-h\t\tShow this message\n"
+               "\t-v\t\tVerbose\n"
+               "\t-o file_name\twrite pruned patterns to file, only if hyphenation of all words is identical\n";
+
+int main(int argc, char **argv)
+{
+    // Check for valid size of judy's internal type
+    assert(sizeof(Word_t) == sizeof(char *));
+
+    char *output_filepath = NULL;
+
+    int c;
+    while ((c = getopt(argc, argv, "hvo:")) != -1)
+        switch (c)
+        {
+        case 'h':
+            printf("%s", usage);
+            return 0;
+        case 'v':
+            verbose = true;
+            break;
+        case 'o':
+            output_filepath = optarg;
+            break;
+        default:
+            fprintf(stderr, "Unknown option `\\x%x'.\n", optopt);
+            return 1;
+        }
+
+    if (argc - optind != 2)
+    {
+        fprintf(stderr, "Missing file paths\n");
+        return 1;
+    }
+
+    // Load and prune patterns
+    Pattern_wrapper pattern_list;
+    if (patterns_load(&pattern_list, argv[optind]))
+    {
+        patterns_free(&pattern_list);
+        return 1;
+    }
+
+    Pattern_wrapper pruned_list;
+    Prune_stats stats;
+    if (prune_patterns(&pattern_list, &pruned_list, &stats))
+    {
+        patterns_free(&pattern_list);
+        return 1;
+    }
+
+    printf("Removed %i duplicate and %i dominated patterns, %i of %i patterns are left\n",
+           stats.duplicate_count, stats.dominated_count, pruned_list.count, pattern_list.count);
+
+    // Hyphenation of words with both sets must be the same
+    Pvoid_t original_judy = (Pvoid_t)NULL;
+    Pvoid_t pruned_judy = (Pvoid_t)NULL;
+    judy_insert_patterns(&pattern_list, &original_judy);
+    judy_insert_patterns(&pruned_list, &pruned_judy);
+
+    double time_original = 0;
+    double time_pruned = 0;
+    int different_count = prune_verify(argv[optind + 1], &original_judy, &pruned_judy,
+                                       &time_original, &time_pruned);
+
+    if (different_count == 0)
+        printf("Hyphenation of all words is identical\n");
+    else if (different_count > 0)
+        printf("Hyphenation differs in %i words\n", different_count);
+
+    int result = different_count == 0 ? 0 : 1;
+    if (output_filepath && result == 0)
+        result = patterns_save(&pruned_list, output_filepath);
+
+    Word_t freed_count;
+    JSLFA(freed_count, original_judy);
+    JSLFA(freed_count, pruned_judy);
+    patterns_free(&pattern_list);
+    patterns_free(&pruned_list);
+
+    return result;
+}
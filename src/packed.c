@@ -0,0 +1,821 @@
+#define _GNU_SOURCE
+
+#include "packed.h"
+#include "patterns.h"
+#include "topology.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+extern bool verbose;
+
+// Names of page modes for verbose output
+static const char *page_mode_names[] = {"default", "hugetlb", "transparent huge"};
+
+/**
+ * Node of temporary trie used only during compilation. Children of node are
+ * linked list starting at first_child, pattern is index of pattern ending in
+ * this node or -1.
+ */
+typedef struct
+{
+    int first_child;
+    int next_sibling;
+    int pattern;
+    unsigned char label;
+} Build_node;
+
+/**
+ * State of one word in packed_code_batch. Substring of word starting at
+ * character j is descended, node is reached but not read yet, b is the next
+ * byte of key and end the character which holds it. Pending_code is the last
+ * found pattern code, which is merged at pending_position in the next round.
+ */
+typedef struct
+{
+    const unsigned char *key;
+    const char *utf8_code;
+    char *hyph_code;
+    int len;
+    int j;
+    int end;
+    int b;
+    uint32_t node;
+    const char *pending_code;
+    int pending_position;
+    int pending_len;
+} Packed_lookup;
+
+// State of replication of trie to one NUMA node
+typedef struct
+{
+    Packed_set *set;
+    const Packed_trie *master;
+    int node;
+    bool huge_pages;
+    int result;
+} Packed_replica_job;
+
+// Private packed.c function which allocates block, huge pages are preferred
+static char *packed_alloc(Packed_trie *trie, size_t size, bool huge_pages)
+{
+    trie->mapped_size = 0;
+    trie->page_mode = PACKED_PAGES_DEFAULT;
+
+    if (huge_pages)
+    {
+        size_t mapped_size = (size + PACKED_HUGE_PAGE_SIZE - 1) & ~(size_t)(PACKED_HUGE_PAGE_SIZE - 1);
+
+        char *memory = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED)
+        {
+            trie->mapped_size = mapped_size;
+            trie->page_mode = PACKED_PAGES_HUGETLB;
+            return memory;
+        }
+
+        // No reserved huge pages, so transparent huge pages are requested
+        memory = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory != MAP_FAILED)
+        {
+            trie->mapped_size = mapped_size;
+            if (madvise(memory, mapped_size, MADV_HUGEPAGE) == 0)
+                trie->page_mode = PACKED_PAGES_THP;
+            return memory;
+        }
+    }
+
+    return malloc(size);
+}
+
+// Private packed.c function which sets pointers to parts of block
+static void packed_attach(Packed_trie *trie)
+{
+    trie->nodes = (const Packed_node *)trie->memory;
+    trie->labels = (const unsigned char *)&trie->memory[trie->node_count * sizeof(Packed_node)];
+    trie->codes = (const char *)&trie->labels[trie->node_count];
+}
+
+// Private packed.c function which returns child with label or 0 if not found
+static inline uint32_t packed_child(const Packed_trie *trie, uint32_t node, unsigned char label)
+{
+    const Packed_node *parent = &trie->nodes[node];
+    const unsigned char *labels = &trie->labels[parent->first_child];
+
+    for (int i = 0; i < parent->child_count; i++)
+        if (labels[i] == label)
+            return parent->first_child + i;
+
+    return 0;
+}
+
+// Private packed.c function for sorting children by their label
+static int compare_labels(const void *a, const void *b, void *build_nodes)
+{
+    const Build_node *nodes = build_nodes;
+    return nodes[*(const int *)a].label - nodes[*(const int *)b].label;
+}
+
+int packed_build(Pattern_wrapper *patterns, Packed_trie *trie, bool huge_pages)
+{
+    memset(trie, 0, sizeof(Packed_trie));
+
+    STARTTm;
+
+    // Temporary trie with linked lists of children
+    int allocated_count = 1024;
+    int build_count = 1;
+    Build_node *build_nodes = malloc(allocated_count * sizeof(Build_node));
+    if (build_nodes == NULL)
+    {
+        printf("Allocation error\n");
+        return 1;
+    }
+    build_nodes[0] = (Build_node){-1, -1, -1, 0};
+
+    for (int i = 0; i < patterns->count; i++)
+    {
+        int node = 0;
+
+        for (const unsigned char *key = (const unsigned char *)patterns->patterns[i].word; *key; key++)
+        {
+            int child = build_nodes[node].first_child;
+            while (child != -1 && build_nodes[child].label != *key)
+                child = build_nodes[child].next_sibling;
+
+            if (child == -1)
+            {
+                if (build_count == allocated_count)
+                {
+                    allocated_count *= 2;
+                    build_nodes = realloc(build_nodes, allocated_count * sizeof(Build_node));
+                    if (build_nodes == NULL)
+                    {
+                        printf("Allocation error\n");
+                        return 1;
+                    }
+                }
+
+                child = build_count++;
+                build_nodes[child] = (Build_node){-1, build_nodes[node].first_child, -1, *key};
+                build_nodes[node].first_child = child;
+            }
+
+            node = child;
+        }
+
+        // Same as in Judy, the last of duplicate patterns is used
+        build_nodes[node].pattern = i;
+    }
+
+    // Breadth first order gives consecutive indexes to children of every node
+    int *order = malloc(build_count * sizeof(int));
+    Packed_node *nodes = calloc(build_count, sizeof(Packed_node));
+    unsigned char *labels = calloc(build_count, sizeof(unsigned char));
+    size_t code_size = 1;
+    for (int i = 0; i < build_count; i++)
+        if (build_nodes[i].pattern != -1)
+            code_size += CODE_PADDED_SIZE(strlen_utf8(patterns->patterns[build_nodes[i].pattern].word));
+    char *codes = calloc(code_size, sizeof(char));
+
+    if (order == NULL || nodes == NULL || labels == NULL || codes == NULL)
+    {
+        printf("Allocation error\n");
+        return 1;
+    }
+
+    int ordered_count = 1;
+    uint32_t code_offset = 1;
+    order[0] = 0;
+
+    for (int i = 0; i < build_count; i++)
+    {
+        const Build_node *build_node = &build_nodes[order[i]];
+
+        nodes[i].first_child = ordered_count;
+        for (int child = build_node->first_child; child != -1; child = build_nodes[child].next_sibling)
+            order[ordered_count + nodes[i].child_count++] = child;
+
+        qsort_r(&order[ordered_count], nodes[i].child_count, sizeof(int), compare_labels, build_nodes);
+        for (int k = 0; k < nodes[i].child_count; k++)
+            labels[ordered_count + k] = build_nodes[order[ordered_count + k]].label;
+        ordered_count += nodes[i].child_count;
+
+        if (build_node->pattern != -1)
+        {
+            Pattern *pattern = &patterns->patterns[build_node->pattern];
+            int len = CODE_PADDED_SIZE(strlen_utf8(pattern->word));
+
+            memcpy(&codes[code_offset], pattern->code, len);
+            nodes[i].code = code_offset;
+            code_offset += len;
+        }
+    }
+
+    // Whole trie is moved to one block
+    trie->node_count = build_count;
+    trie->code_size = code_size;
+    trie->size = build_count * (sizeof(Packed_node) + sizeof(unsigned char)) + code_size;
+    trie->memory = packed_alloc(trie, trie->size, huge_pages);
+    if (trie->memory == NULL)
+    {
+        printf("Allocation error\n");
+        return 1;
+    }
+
+    memcpy(trie->memory, nodes, build_count * sizeof(Packed_node));
+    memcpy(&trie->memory[build_count * sizeof(Packed_node)], labels, build_count);
+    memcpy(&trie->memory[build_count * (sizeof(Packed_node) + 1)], codes, code_size);
+    packed_attach(trie);
+
+    free(build_nodes);
+    free(order);
+    free(nodes);
+    free(labels);
+    free(codes);
+
+    ENDTm;
+
+    if (verbose)
+        printf("Compilation of packed trie         of %u patterns "
+               "took %8.0f microseconds (%.3f per pattern)\n",
+               patterns->count, DeltaUSec, DeltaUSec / patterns->count);
+
+    return 0;
+}
+
+int packed_copy(Packed_trie *destination, const Packed_trie *source, bool huge_pages)
+{
+    *destination = *source;
+
+    destination->memory = packed_alloc(destination, source->size, huge_pages);
+    if (destination->memory == NULL)
+    {
+        printf("Allocation error\n");
+        return 1;
+    }
+
+    memcpy(destination->memory, source->memory, source->size);
+    packed_attach(destination);
+
+    return 0;
+}
+
+void packed_free(Packed_trie *trie)
+{
+    if (trie->mapped_size)
+        munmap(trie->memory, trie->mapped_size);
+    else
+        free(trie->memory);
+
+    trie->memory = NULL;
+}
+
+char *packed_hyphenate(char *word, const Packed_trie *trie, const char *utf8_code)
+{
+    int len = strlen_utf8(word);
+
+    char hyph_code[HYPH_CODE_SIZE(len)];
+    memset(hyph_code, 0, sizeof(hyph_code));
+    const unsigned char *key = (const unsigned char *)word;
+
+    if (verbose)
+        printf("Hyphenating word '%s' with packed trie:\n", word);
+
+    for (int j = 0; j < len; j++)
+    {
+        uint32_t node = 0;
+
+        for (int i = j; i < len; i++)
+        {
+            // Descend by all bytes of character i, root is never a child
+            int b = utf8_code[i];
+            do
+                node = packed_child(trie, node, key[b]);
+            while (node != 0 && ++b < utf8_code[i + 1]);
+
+            if (node == 0)
+                break;
+
+            if (trie->nodes[node].code == 0)
+                continue;
+
+            const char *pattern_code = &trie->codes[trie->nodes[node].code];
+
+            if (verbose)
+                printf("Subword at %i of length %i was found - pattern code: ", j, i - j + 1);
+
+            if (verbose)
+            {
+                for (int k = 0; k <= i - j + 1; k++)
+                    printf("%i", pattern_code[k]);
+                putchar('\n');
+            }
+
+            code_merge(&hyph_code[j], pattern_code, i - j + 1);
+        }
+    }
+
+    char *result = hyphenate_from_code(word, hyph_code);
+    if (verbose)
+        printf("Hyphenation result: '%s'\n\n", result);
+
+    return result;
+}
+
+// Private packed.c function which starts descent of lookup from the root at character j
+static inline void packed_lookup_start(Packed_lookup *lookup, int j)
+{
+    lookup->j = j;
+    lookup->end = j;
+    lookup->b = j < lookup->len ? lookup->utf8_code[j] : 0;
+    lookup->node = 0;
+}
+
+/**
+ * Private packed.c function which reads reached node of lookup, searches
+ * labels of its children and prefetches the found child. Returns false if
+ * word is finished.
+ */
+static inline bool packed_lookup_step(const Packed_trie *trie, Packed_lookup *lookup)
+{
+    if (lookup->pending_code)
+    {
+        code_merge(&lookup->hyph_code[lookup->pending_position], lookup->pending_code,
+                   lookup->pending_len);
+        lookup->pending_code = NULL;
+    }
+
+    if (lookup->j >= lookup->len)
+        return false;
+
+    const Packed_node *node = &trie->nodes[lookup->node];
+
+    // Node after the last byte of character ends substring from j to end - 1
+    if (lookup->node != 0 && node->code != 0 && lookup->b == lookup->utf8_code[lookup->end])
+    {
+        lookup->pending_code = &trie->codes[node->code];
+        lookup->pending_position = lookup->j;
+        lookup->pending_len = lookup->end - lookup->j;
+        __builtin_prefetch(lookup->pending_code);
+    }
+
+    const unsigned char *labels = &trie->labels[node->first_child];
+    unsigned char label = lookup->key[lookup->b];
+    int i = 0;
+
+    // Substring ending with the last character can not be extended
+    int child_count = lookup->end < lookup->len ? node->child_count : 0;
+    while (i < child_count && labels[i] != label)
+        i++;
+
+    if (i == child_count)
+    {
+        packed_lookup_start(lookup, lookup->j + 1);
+        return true;
+    }
+
+    lookup->node = node->first_child + i;
+    if (++lookup->b == lookup->utf8_code[lookup->end + 1])
+        lookup->end++;
+    __builtin_prefetch(&trie->nodes[lookup->node]);
+
+    return true;
+}
+
+void packed_code_batch(char **keys, char **utf8_codes, const int *lens, int count,
+                       const Packed_trie *trie, char **hyph_codes)
+{
+    Packed_lookup lookups[count];
+
+    for (int w = 0; w < count; w++)
+    {
+        lookups[w].key = (const unsigned char *)keys[w];
+        lookups[w].utf8_code = utf8_codes[w];
+        lookups[w].hyph_code = hyph_codes[w];
+        lookups[w].len = lens[w];
+        lookups[w].pending_code = NULL;
+        packed_lookup_start(&lookups[w], 0);
+    }
+
+    // Words which are still searched are kept at the beginning of lookups
+    int active = count;
+    while (active > 0)
+        for (int w = 0; w < active; w++)
+            if (!packed_lookup_step(trie, &lookups[w]))
+            {
+                // Finished word is replaced by the last active one
+                lookups[w--] = lookups[--active];
+            }
+}
+
+void packed_hyphenate_batch(char **words, char **utf8_codes, int count, const Packed_trie *trie,
+                            char **results)
+{
+    int lens[count];
+    char *word_codes[count];
+    int code_size = 0;
+
+    for (int w = 0; w < count; w++)
+    {
+        lens[w] = strlen_utf8(words[w]);
+        code_size += HYPH_CODE_SIZE(lens[w]);
+    }
+
+    char *hyph_codes = calloc(code_size, sizeof(char));
+    if (hyph_codes == NULL)
+    {
+        printf("Allocation error\n");
+        for (int w = 0; w < count; w++)
+            results[w] = NULL;
+        return;
+    }
+
+    code_size = 0;
+    for (int w = 0; w < count; w++)
+    {
+        word_codes[w] = &hyph_codes[code_size];
+        code_size += HYPH_CODE_SIZE(lens[w]);
+    }
+
+    packed_code_batch(words, utf8_codes, lens, count, trie, word_codes);
+
+    for (int w = 0; w < count; w++)
+    {
+        results[w] = hyphenate_from_code(words[w], word_codes[w]);
+
+        if (verbose)
+            printf("Hyphenation result of '%s' in batch: '%s'\n", words[w], results[w]);
+    }
+
+    free(hyph_codes);
+}
+
+int packed_profile(const Packed_trie *trie, const char *file_name, uint32_t *hits)
+{
+    FILE *fp;
+    char *line = NULL;
+    size_t len = 0;
+    ssize_t read;
+    int word_count = 0;
+
+    fp = fopen(file_name, "r");
+    if (fp == NULL)
+    {
+        printf("Cannot open file %s\n", file_name);
+        return -1;
+    }
+
+    while ((read = getline(&line, &len, fp)) != -1)
+    {
+        // Remove new line character
+        if (line[read - 1] == '\n')
+        {
+            line[read - 1] = '\0';
+            read--;
+        }
+
+        // Skip if no word was loaded
+        if (read == 0)
+            continue;
+
+        char *word = add_dots_to_word(read, line);
+        char *utf8_code = create_utf_array(word);
+        const unsigned char *key = (const unsigned char *)word;
+        int word_len = strlen_utf8(word);
+
+        for (int j = 0; j < word_len; j++)
+        {
+            uint32_t node = 0;
+
+            for (int b = utf8_code[j]; b < utf8_code[word_len]; b++)
+            {
+                node = packed_child(trie, node, key[b]);
+                if (node == 0)
+                    break;
+                hits[node]++;
+            }
+        }
+
+        free(utf8_code);
+        free(word);
+        word_count++;
+    }
+
+    fclose(fp);
+    if (line)
+        free(line);
+
+    return word_count;
+}
+
+// Private packed.c function for sorting by hits, hotter first and then by index
+static int compare_hits(const void *a, const void *b, void *hits)
+{
+    const uint64_t *counts = hits;
+    uint32_t first = *(const uint32_t *)a;
+    uint32_t second = *(const uint32_t *)b;
+
+    if (counts[first] != counts[second])
+        return counts[first] > counts[second] ? -1 : 1;
+
+    return first < second ? -1 : first > second;
+}
+
+// Private packed.c function for sorting nodes by offsets of their codes
+static int compare_codes(const void *a, const void *b, void *nodes)
+{
+    const Packed_node *packed_nodes = nodes;
+    uint32_t first = packed_nodes[*(const uint32_t *)a].code;
+    uint32_t second = packed_nodes[*(const uint32_t *)b].code;
+
+    return first < second ? -1 : first > second;
+}
+
+int packed_relayout(const Packed_trie *source, const uint32_t *hits, Packed_trie *trie,
+                    bool huge_pages)
+{
+    uint32_t count = source->node_count;
+
+    memset(trie, 0, sizeof(Packed_trie));
+
+    STARTTm;
+
+    // Heat of node is its hits, heat of parent is the sum of hits of its children
+    uint64_t *node_heat = malloc(count * sizeof(uint64_t));
+    uint64_t *group_heat = calloc(count, sizeof(uint64_t));
+    uint32_t *parents = malloc(count * sizeof(uint32_t));
+    uint32_t *with_code = malloc(count * sizeof(uint32_t));
+    uint32_t *map = malloc(count * sizeof(uint32_t));
+    uint32_t *code_map = calloc(count, sizeof(uint32_t));
+    uint32_t *children = malloc(count * sizeof(uint32_t));
+    Packed_node *nodes = calloc(count, sizeof(Packed_node));
+    unsigned char *labels = calloc(count, sizeof(unsigned char));
+    char *codes = calloc(source->code_size, sizeof(char));
+
+    if (node_heat == NULL || group_heat == NULL || parents == NULL || with_code == NULL ||
+        map == NULL || code_map == NULL || children == NULL || nodes == NULL ||
+        labels == NULL || codes == NULL)
+    {
+        printf("Allocation error\n");
+        return 1;
+    }
+
+    uint32_t parent_count = 0;
+    uint32_t code_count = 0;
+    for (uint32_t n = 0; n < count; n++)
+    {
+        const Packed_node *node = &source->nodes[n];
+
+        node_heat[n] = hits[n];
+        for (uint32_t k = 0; k < node->child_count; k++)
+            group_heat[n] += hits[node->first_child + k];
+
+        if (node->child_count)
+            parents[parent_count++] = n;
+        if (node->code)
+            with_code[code_count++] = n;
+    }
+
+    qsort_r(parents, parent_count, sizeof(uint32_t), compare_hits, group_heat);
+
+    // Root stays at index 0, children of every parent still get consecutive indexes
+    uint32_t ordered_count = 1;
+    map[0] = 0;
+    for (uint32_t p = 0; p < parent_count; p++)
+    {
+        const Packed_node *parent = &source->nodes[parents[p]];
+
+        for (uint32_t k = 0; k < parent->child_count; k++)
+            children[k] = parent->first_child + k;
+        qsort_r(children, parent->child_count, sizeof(uint32_t), compare_hits, node_heat);
+
+        for (uint32_t k = 0; k < parent->child_count; k++)
+            map[children[k]] = ordered_count + k;
+        ordered_count += parent->child_count;
+    }
+
+    // Length of code is the distance to the next code in source
+    qsort_r(with_code, code_count, sizeof(uint32_t), compare_codes, (void *)source->nodes);
+    for (uint32_t c = 0; c < code_count; c++)
+    {
+        uint32_t next = c + 1 < code_count ? source->nodes[with_code[c + 1]].code
+                                           : source->code_size;
+        code_map[with_code[c]] = next - source->nodes[with_code[c]].code;
+    }
+
+    qsort_r(with_code, code_count, sizeof(uint32_t), compare_hits, node_heat);
+    uint32_t code_offset = 1;
+    for (uint32_t c = 0; c < code_count; c++)
+    {
+        uint32_t n = with_code[c];
+        uint32_t code_len = code_map[n];
+
+        memcpy(&codes[code_offset], &source->codes[source->nodes[n].code], code_len);
+        code_map[n] = code_offset;
+        code_offset += code_len;
+    }
+
+    for (uint32_t n = 0; n < count; n++)
+    {
+        const Packed_node *node = &source->nodes[n];
+        Packed_node *copy = &nodes[map[n]];
+
+        // The first child in the new order has the lowest new index
+        copy->first_child = 0;
+        for (uint32_t k = 0; k < node->child_count; k++)
+            if (copy->first_child == 0 || map[node->first_child + k] < copy->first_child)
+                copy->first_child = map[node->first_child + k];
+        if (node->child_count == 0)
+            copy->first_child = ordered_count;
+
+        copy->child_count = node->child_count;
+        copy->code = node->code ? code_map[n] : 0;
+        labels[map[n]] = source->labels[n];
+    }
+
+    // Whole trie is moved to one block
+    trie->node_count = count;
+    trie->code_size = source->code_size;
+    trie->size = source->size;
+    trie->memory = packed_alloc(trie, trie->size, huge_pages);
+    if (trie->memory == NULL)
+    {
+        printf("Allocation error\n");
+        return 1;
+    }
+
+    memcpy(trie->memory, nodes, count * sizeof(Packed_node));
+    memcpy(&trie->memory[count * sizeof(Packed_node)], labels, count);
+    memcpy(&trie->memory[count * (sizeof(Packed_node) + 1)], codes, source->code_size);
+    packed_attach(trie);
+
+    free(node_heat);
+    free(group_heat);
+    free(parents);
+    free(with_code);
+    free(map);
+    free(code_map);
+    free(children);
+    free(nodes);
+    free(labels);
+    free(codes);
+
+    ENDTm;
+
+    if (verbose)
+        printf("Profile guided layout of packed trie of %u nodes took %8.0f microseconds\n",
+               count, DeltaUSec);
+
+    return 0;
+}
+
+uint32_t packed_hot_lines(const Packed_trie *trie, const uint32_t *hits)
+{
+    size_t line_count = (trie->size + PACKED_CACHE_LINE - 1) / PACKED_CACHE_LINE + 1;
+    unsigned char *touched = calloc(line_count, sizeof(unsigned char));
+    uint64_t *heat = malloc(trie->node_count * sizeof(uint64_t));
+    uint32_t *hottest = malloc(trie->node_count * sizeof(uint32_t));
+    uint32_t hot_lines = 0;
+    if (touched == NULL || heat == NULL || hottest == NULL)
+    {
+        printf("Allocation error\n");
+        free(touched);
+        free(heat);
+        free(hottest);
+        return 0;
+    }
+
+    uint64_t total = 0;
+    for (uint32_t n = 0; n < trie->node_count; n++)
+    {
+        heat[n] = hits[n];
+        hottest[n] = n;
+        total += hits[n];
+    }
+    qsort_r(hottest, trie->node_count, sizeof(uint32_t), compare_hits, heat);
+
+    // Only the hottest nodes with PACKED_HOT_SHARE of all hits are counted
+    uint64_t covered = 0;
+    for (uint32_t h = 0; h < trie->node_count && covered < total * PACKED_HOT_SHARE; h++)
+    {
+        uint32_t n = hottest[h];
+        covered += hits[n];
+
+        size_t offsets[] = {(const char *)&trie->nodes[n] - trie->memory,
+                            (const char *)&trie->nodes[n + 1] - trie->memory - 1,
+                            (const char *)&trie->labels[n] - trie->memory, 0, 0};
+        int offset_count = 3;
+        if (trie->nodes[n].code)
+        {
+            offsets[offset_count++] = &trie->codes[trie->nodes[n].code] - trie->memory;
+            offsets[offset_count++] = &trie->codes[trie->nodes[n].code] - trie->memory +
+                                      CODE_VECTOR_SIZE - 1;
+        }
+
+        for (int i = 0; i < offset_count; i++)
+        {
+            size_t line = offsets[i] / PACKED_CACHE_LINE;
+            if (line < line_count && !touched[line])
+            {
+                touched[line] = 1;
+                hot_lines++;
+            }
+        }
+    }
+
+    free(touched);
+    free(heat);
+    free(hottest);
+
+    return hot_lines;
+}
+
+// Private packed.c function which copies trie while running on NUMA node
+static void *packed_replica_thread(void *arg)
+{
+    Packed_replica_job *job = arg;
+
+    topology_bind(&job->set->topology, job->node);
+    job->result = packed_copy(&job->set->replicas[job->node], job->master, job->huge_pages);
+
+    return NULL;
+}
+
+int packed_set_create(Packed_set *set, Pattern_wrapper *patterns, bool huge_pages,
+                      bool numa)
+{
+    Packed_trie master;
+
+    topology_load(&set->topology);
+    set->replica_count = 0;
+
+    if (packed_build(patterns, &master, huge_pages))
+        return 1;
+
+    if (!numa || set->topology.node_count == 1)
+    {
+        set->replicas[0] = master;
+        set->replica_count = 1;
+    }
+    else
+    {
+        pthread_t threads[TOPOLOGY_MAX_NODES];
+        bool started[TOPOLOGY_MAX_NODES];
+        Packed_replica_job jobs[TOPOLOGY_MAX_NODES];
+        int result = 0;
+
+        for (int node = 0; node < set->topology.node_count; node++)
+        {
+            jobs[node] = (Packed_replica_job){set, &master, node, huge_pages, 0};
+            started[node] = pthread_create(&threads[node], NULL, packed_replica_thread,
+                                           &jobs[node]) == 0;
+
+            // Without thread the copy is made on node of this thread
+            if (!started[node])
+                jobs[node].result = packed_copy(&set->replicas[node], &master, huge_pages);
+        }
+
+        for (int node = 0; node < set->topology.node_count; node++)
+        {
+            if (started[node])
+                pthread_join(threads[node], NULL);
+            result |= jobs[node].result;
+        }
+
+        set->replica_count = set->topology.node_count;
+        packed_free(&master);
+
+        if (result)
+            return 1;
+    }
+
+    if (verbose)
+        printf("Packed trie has %u nodes and takes %zu bytes in %s pages, %i replicas\n",
+               set->replicas[0].node_count, set->replicas[0].size,
+               page_mode_names[set->replicas[0].page_mode], set->replica_count);
+
+    return 0;
+}
+
+const Packed_trie *packed_local(Packed_set *set)
+{
+    if (set->replica_count == 1)
+        return &set->replicas[0];
+
+    return &set->replicas[topology_local_node(&set->topology)];
+}
+
+void packed_set_free(Packed_set *set)
+{
+    for (int i = 0; i < set->replica_count; i++)
+        packed_free(&set->replicas[i]);
+
+    set->replica_count = 0;
+}
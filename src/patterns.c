@@ -84,7 +84,8 @@ int patterns_load(Pattern_wrapper *pattern_array, const char *file_name)
         }
 
         pattern_array->patterns[pattern_array->count].code =
-            calloc(strlen_utf8(pattern_array->patterns[pattern_array->count].word) + 1, sizeof(char));
+            calloc(CODE_PADDED_SIZE(strlen_utf8(pattern_array->patterns[pattern_array->count].word)),
+                   sizeof(char));
         if (pattern_array->patterns[pattern_array->count].code == NULL)
         {
             printf("Allocation error\n");
@@ -117,6 +118,42 @@ int patterns_load(Pattern_wrapper *pattern_array, const char *file_name)
     return 0;
 }
 
+int patterns_save(Pattern_wrapper *patterns, const char *file_name)
+{
+    FILE *fp = fopen(file_name, "w");
+    if (fp == NULL)
+    {
+        printf("Cannot open file %s\n", file_name);
+        return 1;
+    }
+
+    for (int i = 0; i < patterns->count; i++)
+    {
+        const char *word = patterns->patterns[i].word;
+        const char *code = patterns->patterns[i].code;
+        int code_index = 0;
+
+        for (int j = 0; word[j] != '\0'; j++)
+        {
+            // Values are written before the first byte of every character
+            if ((word[j] & 0xC0) != 0x80)
+            {
+                if (code[code_index])
+                    fputc('0' + code[code_index], fp);
+                code_index++;
+            }
+            fputc(word[j], fp);
+        }
+
+        if (code[code_index])
+            fputc('0' + code[code_index], fp);
+        fputc('\n', fp);
+    }
+
+    fclose(fp);
+    return 0;
+}
+
 void patterns_free(Pattern_wrapper *pattern_array)
 {
     for (int i = 0; i < pattern_array->count; i++)
@@ -0,0 +1,438 @@
+#define _GNU_SOURCE
+
+#include "pipeline.h"
+#include "hyphenator.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+extern __thread int left_hyphen_min;
+extern __thread int right_hyphen_min;
+
+// Waiting threads spin for a while and then sleep at most 1 millisecond
+#define PIPELINE_SPIN_COUNT 64
+#define PIPELINE_MAX_SLEEP 1000000
+
+/**
+ * Lock-free ring for 1 producer and 1 consumer. Head and tail only grow and
+ * are kept in different cache lines, slot is their value modulo size.
+ */
+typedef struct
+{
+    alignas(64) atomic_size_t head;
+    alignas(64) atomic_size_t tail;
+    Pipeline_batch *slots[PIPELINE_RING_SIZE];
+} Pipeline_ring;
+
+/**
+ * Batch with sequence k goes to worker k % worker_count through its input ring
+ * and comes back through its output ring, so writer reads rings in turn.
+ */
+typedef struct
+{
+    Pipeline_hyphenate hyphenate;
+    void *context;
+    int worker_count;
+    int batch_size;
+    int max_latency;
+    long next_sequence;
+    Pipeline_ring *inputs;
+    Pipeline_ring *outputs;
+} Pipeline;
+
+// Argument of worker thread
+typedef struct
+{
+    Pipeline *pipeline;
+    int index;
+} Pipeline_worker;
+
+static bool ring_try_push(Pipeline_ring *ring, Pipeline_batch *batch)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (tail - head == PIPELINE_RING_SIZE)
+        return false;
+
+    ring->slots[tail % PIPELINE_RING_SIZE] = batch;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+static bool ring_try_pop(Pipeline_ring *ring, Pipeline_batch **batch)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head == tail)
+        return false;
+
+    *batch = ring->slots[head % PIPELINE_RING_SIZE];
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+// Private pipeline.c function for waiting on ring, spins first and then sleeps
+static void pipeline_wait(int *attempt)
+{
+    if (++*attempt < PIPELINE_SPIN_COUNT)
+    {
+        sched_yield();
+        return;
+    }
+
+    long sleep = 1000L << (*attempt - PIPELINE_SPIN_COUNT < 10 ? *attempt - PIPELINE_SPIN_COUNT : 10);
+    struct timespec duration = {0, sleep < PIPELINE_MAX_SLEEP ? sleep : PIPELINE_MAX_SLEEP};
+    nanosleep(&duration, NULL);
+}
+
+static void ring_push(Pipeline_ring *ring, Pipeline_batch *batch)
+{
+    int attempt = 0;
+    while (!ring_try_push(ring, batch))
+        pipeline_wait(&attempt);
+}
+
+static Pipeline_batch *ring_pop(Pipeline_ring *ring)
+{
+    Pipeline_batch *batch;
+    int attempt = 0;
+    while (!ring_try_pop(ring, &batch))
+        pipeline_wait(&attempt);
+
+    return batch;
+}
+
+// Private pipeline.c function which returns monotonic time in milliseconds
+static double pipeline_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+static Pipeline_batch *batch_create(int batch_size, bool command)
+{
+    Pipeline_batch *batch = calloc(1, sizeof(Pipeline_batch));
+    if (batch == NULL)
+        return NULL;
+
+    batch->command = command;
+    batch->left_hyphen_min = left_hyphen_min;
+    batch->right_hyphen_min = right_hyphen_min;
+    batch->text_allocated = 256;
+    batch->text = malloc(batch->text_allocated);
+    batch->offsets = malloc(batch_size * sizeof(int));
+    batch->lengths = malloc(batch_size * sizeof(int));
+    batch->results = calloc(batch_size, sizeof(char *));
+
+    if (batch->text == NULL || batch->offsets == NULL || batch->lengths == NULL ||
+        batch->results == NULL)
+    {
+        printf("Allocation error\n");
+        exit(1);
+    }
+
+    return batch;
+}
+
+static void batch_add(Pipeline_batch *batch, const char *line, int read)
+{
+    if (batch->text_size + read + 1 > batch->text_allocated)
+    {
+        while (batch->text_size + read + 1 > batch->text_allocated)
+            batch->text_allocated *= 2;
+
+        batch->text = realloc(batch->text, batch->text_allocated);
+        if (batch->text == NULL)
+        {
+            printf("Allocation error\n");
+            exit(1);
+        }
+    }
+
+    memcpy(&batch->text[batch->text_size], line, read);
+    batch->text[batch->text_size + read] = '\0';
+    batch->offsets[batch->count] = batch->text_size;
+    batch->lengths[batch->count] = read;
+    batch->text_size += read + 1;
+    batch->count++;
+}
+
+static void batch_free(Pipeline_batch *batch)
+{
+    for (int i = 0; i < batch->count; i++)
+        free(batch->results[i]);
+
+    free(batch->text);
+    free(batch->offsets);
+    free(batch->lengths);
+    free(batch->results);
+    free(batch);
+}
+
+// Private pipeline.c function which passes batch to its worker
+static void pipeline_push(Pipeline *pipeline, Pipeline_batch *batch)
+{
+    batch->sequence = pipeline->next_sequence++;
+    ring_push(&pipeline->inputs[batch->sequence % pipeline->worker_count], batch);
+}
+
+static void *pipeline_worker(void *arg)
+{
+    Pipeline_worker *worker = arg;
+    Pipeline *pipeline = worker->pipeline;
+    Pipeline_ring *input = &pipeline->inputs[worker->index];
+    Pipeline_ring *output = &pipeline->outputs[worker->index];
+
+    while (true)
+    {
+        Pipeline_batch *batch = ring_pop(input);
+
+        // End of input is passed to writer as well
+        if (batch != NULL && !batch->command)
+        {
+            left_hyphen_min = batch->left_hyphen_min;
+            right_hyphen_min = batch->right_hyphen_min;
+
+            for (int i = 0; i < batch->count; i++)
+                batch->results[i] = pipeline->hyphenate(&batch->text[batch->offsets[i]],
+                                                        batch->lengths[i], pipeline->context);
+        }
+
+        ring_push(output, batch);
+        if (batch == NULL)
+            return NULL;
+    }
+}
+
+static void *pipeline_writer(void *arg)
+{
+    Pipeline *pipeline = arg;
+
+    for (long sequence = 0;; sequence++)
+    {
+        Pipeline_ring *output = &pipeline->outputs[sequence % pipeline->worker_count];
+        Pipeline_batch *batch;
+
+        // Everything written so far is shown before waiting
+        if (!ring_try_pop(output, &batch))
+        {
+            fflush(stdout);
+            batch = ring_pop(output);
+        }
+
+        if (batch == NULL)
+            break;
+
+        if (batch->command)
+        {
+            left_hyphen_min = batch->left_hyphen_min;
+            right_hyphen_min = batch->right_hyphen_min;
+            command_report(batch->text, batch->lengths[0]);
+        }
+        else
+        {
+            for (int i = 0; i < batch->count; i++)
+            {
+                fputs(batch->results[i], stdout);
+                putchar('\n');
+            }
+        }
+
+        batch_free(batch);
+    }
+
+    fflush(stdout);
+    return NULL;
+}
+
+/**
+ * Private pipeline.c function which adds one line to the current batch.
+ * Returns true if :q command ends the input.
+ */
+static bool pipeline_line(Pipeline *pipeline, Pipeline_batch **batch, double *batch_start,
+                          char *line, int read)
+{
+    // Skip if no word was loaded
+    if (read == 0)
+        return false;
+
+    // Commands are applied between batches, so earlier words keep old values
+    if (line[0] == ':')
+    {
+        if (*batch)
+            pipeline_push(pipeline, *batch);
+        *batch = NULL;
+
+        if (command_apply(line, read))
+            return true;
+
+        Pipeline_batch *command = batch_create(1, true);
+        batch_add(command, line, read);
+        pipeline_push(pipeline, command);
+        return false;
+    }
+
+    if (*batch == NULL)
+    {
+        *batch = batch_create(pipeline->batch_size, false);
+        *batch_start = pipeline_now();
+    }
+
+    batch_add(*batch, line, read);
+    if ((*batch)->count == pipeline->batch_size)
+    {
+        pipeline_push(pipeline, *batch);
+        *batch = NULL;
+    }
+
+    return false;
+}
+
+// Private pipeline.c function of reader stage running in the calling thread
+static void pipeline_reader(Pipeline *pipeline, int fd)
+{
+    char *pending = malloc(PIPELINE_CHUNK_SIZE);
+    size_t pending_size = 0;
+    size_t pending_allocated = PIPELINE_CHUNK_SIZE;
+    Pipeline_batch *batch = NULL;
+    double batch_start = 0;
+    bool quit = false;
+
+    if (pending == NULL)
+    {
+        printf("Allocation error\n");
+        exit(1);
+    }
+
+    while (!quit)
+    {
+        // Not full batch waits for more input only until its latency runs out
+        int timeout = -1;
+        if (batch)
+        {
+            timeout = pipeline->max_latency - (int)(pipeline_now() - batch_start);
+            if (timeout < 0)
+                timeout = 0;
+        }
+
+        struct pollfd input = {fd, POLLIN, 0};
+        int ready = poll(&input, 1, timeout);
+        if (ready == 0)
+        {
+            pipeline_push(pipeline, batch);
+            batch = NULL;
+            continue;
+        }
+
+        if (pending_size + PIPELINE_CHUNK_SIZE > pending_allocated)
+        {
+            pending_allocated *= 2;
+            pending = realloc(pending, pending_allocated);
+            if (pending == NULL)
+            {
+                printf("Allocation error\n");
+                exit(1);
+            }
+        }
+
+        ssize_t read_size = read(fd, &pending[pending_size], PIPELINE_CHUNK_SIZE);
+        if (read_size < 0 && errno == EINTR)
+            continue;
+        if (read_size <= 0)
+            break;
+        pending_size += read_size;
+
+        // Split all complete lines, the rest waits for next chunk
+        size_t line_start = 0;
+        char *newline;
+        while (!quit && (newline = memchr(&pending[line_start], '\n', pending_size - line_start)))
+        {
+            *newline = '\0';
+            quit = pipeline_line(pipeline, &batch, &batch_start, &pending[line_start],
+                                 newline - &pending[line_start]);
+            line_start = newline - pending + 1;
+        }
+
+        memmove(pending, &pending[line_start], pending_size - line_start);
+        pending_size -= line_start;
+    }
+
+    // Last line without new line character
+    if (!quit && pending_size > 0)
+    {
+        pending[pending_size] = '\0';
+        pipeline_line(pipeline, &batch, &batch_start, pending, pending_size);
+    }
+
+    if (batch)
+        pipeline_push(pipeline, batch);
+
+    // Every worker ends after all of its batches
+    for (int i = 0; i < pipeline->worker_count; i++)
+        ring_push(&pipeline->inputs[i], NULL);
+
+    free(pending);
+}
+
+void pipeline_run(int fd, Pipeline_hyphenate hyphenate, void *context, int worker_count,
+                  int batch_size, int max_latency)
+{
+    Pipeline pipeline = {hyphenate, context, worker_count, batch_size, max_latency, 0, NULL, NULL};
+    pthread_t workers[worker_count];
+    Pipeline_worker worker_args[worker_count];
+    pthread_t writer;
+
+    pipeline.inputs = aligned_alloc(alignof(Pipeline_ring), worker_count * sizeof(Pipeline_ring));
+    pipeline.outputs = aligned_alloc(alignof(Pipeline_ring), worker_count * sizeof(Pipeline_ring));
+    if (pipeline.inputs == NULL || pipeline.outputs == NULL)
+    {
+        printf("Allocation error\n");
+        return;
+    }
+
+    for (int i = 0; i < worker_count; i++)
+    {
+        atomic_init(&pipeline.inputs[i].head, 0);
+        atomic_init(&pipeline.inputs[i].tail, 0);
+        atomic_init(&pipeline.outputs[i].head, 0);
+        atomic_init(&pipeline.outputs[i].tail, 0);
+    }
+
+    for (int i = 0; i < worker_count; i++)
+    {
+        worker_args[i] = (Pipeline_worker){&pipeline, i};
+        if (pthread_create(&workers[i], NULL, pipeline_worker, &worker_args[i]))
+        {
+            printf("Thread creation error\n");
+            exit(1);
+        }
+    }
+
+    if (pthread_create(&writer, NULL, pipeline_writer, &pipeline))
+    {
+        printf("Thread creation error\n");
+        exit(1);
+    }
+
+    pipeline_reader(&pipeline, fd);
+
+    for (int i = 0; i < worker_count; i++)
+        pthread_join(workers[i], NULL);
+    pthread_join(writer, NULL);
+
+    free(pipeline.inputs);
+    free(pipeline.outputs);
+}
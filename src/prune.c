@@ -0,0 +1,200 @@
+#define _GNU_SOURCE
+
+#include "prune.h"
+#include "patterns.h"
+#include "judy.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+// Necessary Judy settings
+#define JUDYERROR_SAMPLE 1 // use default Judy error handler
+
+extern bool verbose;
+
+/**
+ * Private prune.c function which decides if pattern is dominated by patterns
+ * in words_judy. Every proper substring of the pattern is searched and
+ * maximum of their values is kept for every position of the pattern.
+ */
+static bool prune_dominated(Pattern *pattern, Pvoid_t words_judy, Pattern *all_patterns)
+{
+    char *word = pattern->word;
+    int len = strlen_utf8(word);
+    Word_t *PValue;
+
+    // Offsets of characters are stored in char
+    if (strlen(word) > PRUNE_MAXWORDBYTES)
+        return false;
+
+    char covered[len + 1];
+    memset(covered, 0, sizeof(covered));
+    char *utf8_code = create_utf_array(word);
+
+    for (int j = 0; j < len; j++)
+        for (int i = j + 1; i <= len; i++)
+        {
+            if (j == 0 && i == len)
+                continue;
+
+            char backup = word[(int)utf8_code[i]];
+            word[(int)utf8_code[i]] = '\0';
+            JSLG(PValue, words_judy, (uint8_t *)&word[(int)utf8_code[j]]);
+            word[(int)utf8_code[i]] = backup;
+
+            if (PValue == NULL)
+                continue;
+
+            // Value of JudySL is index of the last duplicate increased by 1
+            const char *code = all_patterns[*PValue - 1].code;
+            for (int k = 0; k <= i - j; k++)
+                if (code[k] > covered[j + k])
+                    covered[j + k] = code[k];
+        }
+
+    free(utf8_code);
+
+    for (int k = 0; k <= len; k++)
+        if (pattern->code[k] > covered[k])
+            return false;
+
+    return true;
+}
+
+int prune_patterns(Pattern_wrapper *patterns, Pattern_wrapper *pruned, Prune_stats *stats)
+{
+    Pvoid_t words_judy = (Pvoid_t)NULL;
+    Word_t *PValue;
+
+    stats->duplicate_count = 0;
+    stats->dominated_count = 0;
+    pruned->count = 0;
+    pruned->patterns = malloc((patterns->count + 1) * sizeof(Pattern));
+    if (pruned->patterns == NULL)
+    {
+        printf("Allocation error\n");
+        return 1;
+    }
+
+    STARTTm;
+
+    // The last of duplicate patterns is used
+    for (int i = 0; i < patterns->count; i++)
+    {
+        JSLI(PValue, words_judy, (uint8_t *)patterns->patterns[i].word);
+        *PValue = i + 1;
+    }
+
+    for (int i = 0; i < patterns->count; i++)
+    {
+        Pattern *pattern = &patterns->patterns[i];
+
+        JSLG(PValue, words_judy, (uint8_t *)pattern->word);
+        if (*PValue != (Word_t)i + 1)
+        {
+            stats->duplicate_count++;
+            if (verbose)
+                printf("Pattern '%s' is a duplicate\n", pattern->word);
+            continue;
+        }
+
+        if (prune_dominated(pattern, words_judy, patterns->patterns))
+        {
+            stats->dominated_count++;
+            if (verbose)
+                printf("Pattern '%s' is dominated\n", pattern->word);
+            continue;
+        }
+
+        int code_size = CODE_PADDED_SIZE(strlen_utf8(pattern->word));
+        Pattern *copy = &pruned->patterns[pruned->count];
+        copy->word = strdup(pattern->word);
+        copy->code = malloc(code_size);
+        if (copy->word == NULL || copy->code == NULL)
+        {
+            printf("Allocation error\n");
+            return 1;
+        }
+
+        memcpy(copy->code, pattern->code, code_size);
+        pruned->count++;
+    }
+
+    ENDTm;
+
+    Word_t freed_count;
+    JSLFA(freed_count, words_judy);
+
+    if (verbose)
+        printf("Pruning of %u patterns took %8.0f microseconds, %i duplicate and "
+               "%i dominated patterns were removed\n",
+               patterns->count, DeltaUSec, stats->duplicate_count, stats->dominated_count);
+
+    return 0;
+}
+
+int prune_verify(const char *file_name, Pvoid_t *original_judy, Pvoid_t *pruned_judy,
+                 double *time_original, double *time_pruned)
+{
+    FILE *fp;
+    char *line = NULL;
+    size_t len = 0;
+    ssize_t read;
+    int different_count = 0;
+
+    fp = fopen(file_name, "r");
+    if (fp == NULL)
+    {
+        printf("Cannot open file %s\n", file_name);
+        return -1;
+    }
+
+    while ((read = getline(&line, &len, fp)) != -1)
+    {
+        // Remove new line character
+        if (line[read - 1] == '\n')
+        {
+            line[read - 1] = '\0';
+            read--;
+        }
+
+        // Skip if no word was loaded or if it is too long
+        if (read == 0 || read + 2 > PRUNE_MAXWORDBYTES)
+            continue;
+
+        char *word = add_dots_to_word(read, line);
+        char *utf8_code = create_utf_array(word);
+
+        STARTTm;
+        char *original_hyphenated = judy_hyphenate(word, original_judy, utf8_code);
+        ENDTm;
+        *time_original += DeltaUSec;
+
+        STARTTm;
+        char *pruned_hyphenated = judy_hyphenate(word, pruned_judy, utf8_code);
+        ENDTm;
+        *time_pruned += DeltaUSec;
+
+        if (strcmp(original_hyphenated, pruned_hyphenated) != 0)
+        {
+            different_count++;
+            if (verbose)
+                printf("Word '%s' is hyphenated as '%s' instead of '%s'\n", line,
+                       pruned_hyphenated, original_hyphenated);
+        }
+
+        free(original_hyphenated);
+        free(pruned_hyphenated);
+        free(utf8_code);
+        free(word);
+    }
+
+    fclose(fp);
+    if (line)
+        free(line);
+
+    return different_count;
+}
@@ -0,0 +1,381 @@
+#define _GNU_SOURCE
+
+#include "text.h"
+#include "alphabet.h"
+#include "judy.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <wctype.h>
+
+extern __thread int left_hyphen_min;
+extern __thread int right_hyphen_min;
+extern char hyphenation_char;
+extern int batch_size;
+
+/**
+ * Word of input waiting in batch. Key is dotted word folded to lower case, in
+ * utf8 or in symbols of alphabet, with byte offsets of characters in
+ * utf8_code. Offsets holds byte offsets of characters in the original word.
+ */
+typedef struct
+{
+    const char *word;
+    int byte_len;
+    int len;
+    int offsets[TEXT_MAXWORD + 1];
+    char key[4 * TEXT_MAXWORD + 3];
+    char utf8_code[TEXT_MAXWORD + 3];
+    char hyph_code[HYPH_CODE_SIZE(TEXT_MAXWORD + 2)];
+} Text_word;
+
+/**
+ * Output buffer and data structures used for hyphenation of words. Input up to
+ * cursor is already written, words are hyphenated in batches of batch_size.
+ */
+typedef struct
+{
+    Pvoid_t *pattern_judy;
+    Alphabet *alphabet;
+    char hyphen[sizeof(TEXT_SOFT_HYPHEN)];
+    int hyphen_len;
+    char *output;
+    size_t output_size;
+    const char *cursor;
+    Text_word *batch;
+    int batch_count;
+} Text_state;
+
+// Private text.c function which writes all buffered output
+static void text_flush(Text_state *state)
+{
+    fwrite(state->output, 1, state->output_size, stdout);
+    state->output_size = 0;
+}
+
+// Private text.c function which appends bytes to output
+static void text_emit(Text_state *state, const char *bytes, size_t size)
+{
+    if (state->output_size + size > TEXT_BUFFER_SIZE)
+        text_flush(state);
+
+    if (size > TEXT_BUFFER_SIZE)
+    {
+        fwrite(bytes, 1, size, stdout);
+        return;
+    }
+
+    memcpy(&state->output[state->output_size], bytes, size);
+    state->output_size += size;
+}
+
+// Private text.c function, true for ASCII letters and all bytes of non ASCII characters
+static inline bool text_letter_byte(unsigned char byte)
+{
+    return byte >= 0x80 || ((byte | 0x20) >= 'a' && (byte | 0x20) <= 'z');
+}
+
+/**
+ * Private text.c function which returns the number of leading bytes which are
+ * letter bytes if letters is true, or which are not letter bytes otherwise.
+ * With SSE2 CODE_VECTOR_SIZE bytes are classified at once.
+ */
+static size_t text_span(const unsigned char *bytes, size_t size, bool letters)
+{
+    size_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i before_a = _mm_set1_epi8('a' - 1);
+    const __m128i after_z = _mm_set1_epi8('z' + 1);
+
+    for (; i + CODE_VECTOR_SIZE <= size; i += CODE_VECTOR_SIZE)
+    {
+        __m128i values = _mm_loadu_si128((const __m128i *)&bytes[i]);
+
+        // Bytes from 0x80 are negative, so they are never between a and z
+        __m128i lower = _mm_or_si128(values, case_bit);
+        __m128i ascii_letters = _mm_and_si128(_mm_cmpgt_epi8(lower, before_a),
+                                              _mm_cmpgt_epi8(after_z, lower));
+        int letter_mask = _mm_movemask_epi8(ascii_letters) | _mm_movemask_epi8(values);
+
+        int other_mask = (letters ? ~letter_mask : letter_mask) & 0xFFFF;
+        if (other_mask)
+            return i + __builtin_ctz(other_mask);
+    }
+#endif
+
+    while (i < size && text_letter_byte(bytes[i]) == letters)
+        i++;
+
+    return i;
+}
+
+/**
+ * Private text.c function which hyphenates all words of batch with
+ * interleaved Judy lookups and writes input up to the end of the last word
+ * with hyphens inserted.
+ */
+static void text_flush_batch(Text_state *state)
+{
+    int count = state->batch_count;
+    char *keys[count];
+    char *utf8_codes[count];
+    char *hyph_codes[count];
+    int lens[count];
+
+    for (int w = 0; w < count; w++)
+    {
+        keys[w] = state->batch[w].key;
+        utf8_codes[w] = state->batch[w].utf8_code;
+        hyph_codes[w] = state->batch[w].hyph_code;
+        lens[w] = state->batch[w].len + 2;
+    }
+
+    judy_code_batch(keys, utf8_codes, lens, count, state->pattern_judy, hyph_codes);
+
+    for (int w = 0; w < count; w++)
+    {
+        Text_word *word = &state->batch[w];
+        uint64_t breaks[CODE_BREAK_WORDS(TEXT_MAXWORD + 2)];
+        code_breaks(word->hyph_code, word->len + 2, breaks);
+
+        text_emit(state, state->cursor, word->word - state->cursor);
+
+        // Break at position p of dotted word is before character p - 1 of word
+        int written = 0;
+        for (int b = 0; b < CODE_BREAK_WORDS(word->len + 2); b++)
+            for (uint64_t bits = breaks[b]; bits; bits &= bits - 1)
+            {
+                int offset = word->offsets[b * 64 + __builtin_ctzll(bits) - 1];
+
+                text_emit(state, &word->word[written], offset - written);
+                text_emit(state, state->hyphen, state->hyphen_len);
+                written = offset;
+            }
+
+        text_emit(state, &word->word[written], word->byte_len - written);
+        state->cursor = word->word + word->byte_len;
+    }
+
+    state->batch_count = 0;
+}
+
+/**
+ * Private text.c function which adds word of len characters to batch, folded
+ * holds its lower case code points and offsets byte offsets of characters.
+ * Words which can not be hyphenated are not added, they are written with the
+ * rest of input.
+ */
+static void text_word(Text_state *state, const char *word, int byte_len, const int *folded,
+                      const int *offsets, int len)
+{
+    // Too long words and words without allowed position are not searched
+    if (len > TEXT_MAXWORD || len < left_hyphen_min + right_hyphen_min)
+        return;
+
+    Text_word *entry = &state->batch[state->batch_count];
+
+    if (state->alphabet)
+    {
+        unsigned char dot = alphabet_symbol(state->alphabet, '.');
+
+        // Every symbol is 1 byte
+        entry->key[0] = dot;
+        for (int k = 0; k < len; k++)
+            entry->key[k + 1] = alphabet_symbol(state->alphabet, folded[k]);
+        entry->key[len + 1] = dot;
+        entry->key[len + 2] = '\0';
+
+        for (int k = 0; k <= len + 2; k++)
+            entry->utf8_code[k] = k;
+    }
+    else
+    {
+        int key_len = 1;
+
+        entry->key[0] = '.';
+        entry->utf8_code[0] = 0;
+        for (int k = 0; k < len; k++)
+        {
+            // Offsets of characters are stored in char
+            if (key_len > 120)
+                return;
+
+            entry->utf8_code[k + 1] = key_len;
+            key_len += utf8_encode(folded[k], &entry->key[key_len]);
+        }
+        entry->utf8_code[len + 1] = key_len;
+        entry->key[key_len++] = '.';
+        entry->utf8_code[len + 2] = key_len;
+        entry->key[key_len] = '\0';
+    }
+
+    entry->word = word;
+    entry->byte_len = byte_len;
+    entry->len = len;
+    memcpy(entry->offsets, offsets, len * sizeof(int));
+    memset(entry->hyph_code, 0, sizeof(entry->hyph_code));
+
+    if (++state->batch_count == batch_size)
+        text_flush_batch(state);
+}
+
+// Private text.c function which decides if non ASCII character is letter
+static inline bool text_letter(Text_state *state, int code_point, int folded)
+{
+    return iswalpha(code_point) ||
+           (state->alphabet && alphabet_symbol(state->alphabet, folded) != ALPHABET_UNKNOWN);
+}
+
+/**
+ * Private text.c function which splits run of letter bytes into words. Non
+ * ASCII characters which are not letters end words.
+ */
+static void text_token(Text_state *state, const char *token, size_t size)
+{
+    int folded[TEXT_MAXWORD];
+    int offsets[TEXT_MAXWORD + 1];
+    size_t start = 0;
+    int len = 0;
+
+    for (size_t i = 0; i < size;)
+    {
+        int code_point;
+        int char_len = 1;
+        unsigned char byte = token[i];
+
+        if (byte < 0x80)
+            code_point = byte;
+        else
+            char_len = utf8_decode(&token[i], &code_point);
+
+        int lower = byte < 0x80 ? (byte | 0x20) : (int)towlower(code_point);
+
+        if (byte >= 0x80 && !text_letter(state, code_point, lower))
+        {
+            if (len > 0)
+                text_word(state, &token[start], i - start, folded, offsets, len);
+
+            i += char_len;
+            start = i;
+            len = 0;
+            continue;
+        }
+
+        // Characters behind TEXT_MAXWORD are only counted
+        if (len < TEXT_MAXWORD)
+        {
+            folded[len] = lower;
+            offsets[len] = i - start;
+        }
+        len++;
+        i += char_len;
+    }
+
+    if (len > 0)
+        text_word(state, &token[start], size - start, folded, offsets, len);
+}
+
+/**
+ * Private text.c function which hyphenates text of buffer and returns the
+ * number of processed bytes. If it is not the last buffer, word at the end
+ * can continue in the next read, so it is kept for the next call. All
+ * processed bytes are written before return, because buffer is reused.
+ */
+static size_t text_process(Text_state *state, const char *buffer, size_t size, bool last)
+{
+    const unsigned char *bytes = (const unsigned char *)buffer;
+    size_t end = size;
+
+    if (!last)
+    {
+        while (end > 0 && text_letter_byte(bytes[end - 1]))
+            end--;
+
+        // Buffer without any separator is processed whole
+        if (end == 0)
+            end = size;
+    }
+
+    size_t position = 0;
+    state->cursor = buffer;
+    while (position < end)
+    {
+        position += text_span(&bytes[position], end - position, false);
+
+        size_t letters = text_span(&bytes[position], end - position, true);
+        if (letters > 0)
+            text_token(state, &buffer[position], letters);
+        position += letters;
+    }
+
+    if (state->batch_count > 0)
+        text_flush_batch(state);
+    text_emit(state, state->cursor, &buffer[end] - state->cursor);
+
+    return end;
+}
+
+int text_hyphenate(int fd, Pvoid_t *pattern_judy, Alphabet *alphabet, bool soft_hyphen)
+{
+    Text_state state = {pattern_judy, alphabet, {0}, 0, NULL, 0, NULL, NULL, 0};
+    char *buffer = malloc(TEXT_BUFFER_SIZE + 1);
+    state.output = malloc(TEXT_BUFFER_SIZE);
+    state.batch = malloc(batch_size * sizeof(Text_word));
+    if (buffer == NULL || state.output == NULL || state.batch == NULL)
+    {
+        printf("Allocation error\n");
+        free(buffer);
+        free(state.output);
+        free(state.batch);
+        return 1;
+    }
+
+    if (soft_hyphen)
+        strcpy(state.hyphen, TEXT_SOFT_HYPHEN);
+    else
+        state.hyphen[0] = hyphenation_char;
+    state.hyphen_len = strlen(state.hyphen);
+
+    size_t size = 0;
+    bool last = false;
+    int result = 0;
+
+    while (!last)
+    {
+        ssize_t read_size = read(fd, &buffer[size], TEXT_BUFFER_SIZE - size);
+        if (read_size < 0 && errno == EINTR)
+            continue;
+
+        if (read_size < 0)
+        {
+            fprintf(stderr, "Cannot read input\n");
+            result = 1;
+        }
+
+        last = read_size <= 0;
+        if (read_size > 0)
+            size += read_size;
+
+        // Decoding of characters stops at the end of data
+        buffer[size] = '\0';
+
+        size_t processed = text_process(&state, buffer, size, last);
+        memmove(buffer, &buffer[processed], size - processed);
+        size -= processed;
+    }
+
+    text_flush(&state);
+    fflush(stdout);
+
+    free(buffer);
+    free(state.output);
+    free(state.batch);
+
+    return result;
+}
@@ -0,0 +1,94 @@
+#define _GNU_SOURCE
+
+#include "topology.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Private topology.c function which parses cpulist like "0-3,8-11" into cpus
+static int topology_parse_cpulist(const char *file_name, cpu_set_t *cpus)
+{
+    FILE *fp = fopen(file_name, "r");
+    if (fp == NULL)
+        return 1;
+
+    char line[4096];
+    if (fgets(line, sizeof(line), fp) == NULL)
+    {
+        fclose(fp);
+        return 1;
+    }
+    fclose(fp);
+
+    CPU_ZERO(cpus);
+    for (char *token = strtok(line, ",\n"); token; token = strtok(NULL, ",\n"))
+    {
+        int first, last;
+        int parsed = sscanf(token, "%d-%d", &first, &last);
+        if (parsed < 1)
+            continue;
+        if (parsed == 1)
+            last = first;
+
+        for (int cpu = first; cpu <= last && cpu < TOPOLOGY_MAX_CPUS; cpu++)
+            CPU_SET(cpu, cpus);
+    }
+
+    return 0;
+}
+
+int topology_load(Topology *topology)
+{
+    char file_name[64];
+
+    topology->node_count = 0;
+    memset(topology->cpu_node, 0, sizeof(topology->cpu_node));
+
+    for (int id = 0; id < TOPOLOGY_MAX_NODES; id++)
+    {
+        int index = topology->node_count;
+
+        snprintf(file_name, sizeof(file_name), "/sys/devices/system/node/node%i/cpulist", id);
+        if (topology_parse_cpulist(file_name, &topology->cpus[index]))
+            continue;
+
+        // Nodes with memory only can not run worker threads
+        if (CPU_COUNT(&topology->cpus[index]) == 0)
+            continue;
+
+        topology->node_ids[index] = id;
+        for (int cpu = 0; cpu < TOPOLOGY_MAX_CPUS; cpu++)
+            if (CPU_ISSET(cpu, &topology->cpus[index]))
+                topology->cpu_node[cpu] = index;
+
+        topology->node_count++;
+    }
+
+    // Single node machine or /sys is not available
+    if (topology->node_count == 0)
+    {
+        topology->node_count = 1;
+        topology->node_ids[0] = 0;
+        CPU_ZERO(&topology->cpus[0]);
+        for (int cpu = 0; cpu < TOPOLOGY_MAX_CPUS; cpu++)
+            CPU_SET(cpu, &topology->cpus[0]);
+    }
+
+    return topology->node_count;
+}
+
+int topology_local_node(const Topology *topology)
+{
+    int cpu = sched_getcpu();
+    if (cpu < 0 || cpu >= TOPOLOGY_MAX_CPUS)
+        return 0;
+
+    return topology->cpu_node[cpu];
+}
+
+int topology_bind(const Topology *topology, int node)
+{
+    return sched_setaffinity(0, sizeof(cpu_set_t), &topology->cpus[node]) != 0;
+}
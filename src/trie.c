@@ -27,40 +27,102 @@ char *trie_hyphenate(char *word, cp_trie *cprops_patricia_trie, const char *utf8
     char backup;
     int len = strlen_utf8(word);
 
-    char hyph_code[len + 1];
-    memset(hyph_code, 0, (len + 1) * sizeof(char));
+    char hyph_code[HYPH_CODE_SIZE(len)];
+    memset(hyph_code, 0, sizeof(hyph_code));
     const char *pattern_code = NULL;
+    void *longest_code = NULL;
+    int lookup_count = 0;
 
     if (verbose)
         printf("Hyphenating word '%s' with Trie:\n", word);
 
-    for (int i = 1; i <= len; i++)
+    for (int j = 0; j < len; j++)
     {
-        for (int j = 0; j <= len - i; j++)
+        // Count of patterns which are prefixes of the rest of the word
+        int remaining = cp_trie_prefix_match(cprops_patricia_trie, &word[(int)utf8_code[j]],
+                                             &longest_code);
+        lookup_count++;
+
+        // Substrings starting at j are extended until all of them are found
+        for (int i = 1; i <= len - j && remaining > 0; i++)
         {
             backup = word[(int)utf8_code[j + i]];
             word[(int)utf8_code[j + i]] = '\0';
 
             pattern_code = cp_trie_exact_match(cprops_patricia_trie, &word[(int)utf8_code[j]]);
+            lookup_count++;
 
             if (pattern_code != NULL)
             {
                 if (verbose)
                     printf("Subword '%s'\t\t was found - pattern code: ", &word[(int)utf8_code[j]]);
 
-                for (int k = 0; k <= i; k++)
+                if (verbose)
                 {
-                    if (verbose)
+                    for (int k = 0; k <= i; k++)
                         printf("%i", pattern_code[k]);
-                    if (pattern_code[k] > hyph_code[j + k])
-                        hyph_code[j + k] = pattern_code[k];
+                    putchar('\n');
                 }
 
+                code_merge(&hyph_code[j], pattern_code, i);
+
+                remaining--;
+            }
+
+            word[(int)utf8_code[j + i]] = backup;
+        }
+    }
+
+    char *result = hyphenate_from_code(word, hyph_code);
+    if (verbose)
+        printf("Hyphenation result: '%s' after %i lookups\n\n", result, lookup_count);
+
+    return result;
+}
+
+char *trie_hyphenate_symbols(char *word, unsigned char *symbols, int len,
+                             cp_trie *cprops_patricia_trie)
+{
+    unsigned char backup;
+
+    char hyph_code[HYPH_CODE_SIZE(len)];
+    memset(hyph_code, 0, sizeof(hyph_code));
+    const char *pattern_code = NULL;
+    void *longest_code = NULL;
+
+    if (verbose)
+        printf("Hyphenating word '%s' with Trie and alphabet:\n", word);
+
+    for (int j = 0; j < len; j++)
+    {
+        int remaining = cp_trie_prefix_match(cprops_patricia_trie, (char *)&symbols[j],
+                                             &longest_code);
+
+        for (int i = 1; i <= len - j && remaining > 0; i++)
+        {
+            backup = symbols[j + i];
+            symbols[j + i] = '\0';
+
+            pattern_code = cp_trie_exact_match(cprops_patricia_trie, (char *)&symbols[j]);
+
+            if (pattern_code != NULL)
+            {
+                if (verbose)
+                    printf("Subword at %i of length %i was found - pattern code: ", j, i);
+
                 if (verbose)
+                {
+                    for (int k = 0; k <= i; k++)
+                        printf("%i", pattern_code[k]);
                     putchar('\n');
+                }
+
+                code_merge(&hyph_code[j], pattern_code, i);
+
+                remaining--;
             }
 
-            word[(int)utf8_code[j + i]] = backup;
+            symbols[j + i] = backup;
         }
     }
 
@@ -1,11 +1,19 @@
+#define _GNU_SOURCE
+
 #include "utils.h"
 #include "patterns.h"
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
-extern int left_hyphen_min;
-extern int right_hyphen_min;
+// Every thread can hyphenate with its own values
+extern __thread int left_hyphen_min;
+extern __thread int right_hyphen_min;
 extern bool verbose;
 extern char hyphenation_char;
 
@@ -46,6 +54,72 @@ int strlen_utf8(const char *str)
     return q;
 }
 
+int utf8_decode(const char *str, int *code_point)
+{
+    unsigned char c = str[0];
+    int length;
+
+    if ((c & 0xE0) == 0xC0)
+    {
+        length = 2;
+        *code_point = c & 0x1F;
+    }
+    else if ((c & 0xF0) == 0xE0)
+    {
+        length = 3;
+        *code_point = c & 0x0F;
+    }
+    else if ((c & 0xF8) == 0xF0)
+    {
+        length = 4;
+        *code_point = c & 0x07;
+    }
+    else
+    {
+        *code_point = c;
+        return 1;
+    }
+
+    for (int i = 1; i < length; i++)
+    {
+        if (str[i] == '\0')
+            return i;
+        *code_point = (*code_point << 6) | (str[i] & 0x3F);
+    }
+
+    return length;
+}
+
+int utf8_encode(int code_point, char *buffer)
+{
+    if (code_point < 0x80)
+    {
+        buffer[0] = code_point;
+        return 1;
+    }
+
+    if (code_point < 0x800)
+    {
+        buffer[0] = 0xC0 | (code_point >> 6);
+        buffer[1] = 0x80 | (code_point & 0x3F);
+        return 2;
+    }
+
+    if (code_point < 0x10000)
+    {
+        buffer[0] = 0xE0 | (code_point >> 12);
+        buffer[1] = 0x80 | ((code_point >> 6) & 0x3F);
+        buffer[2] = 0x80 | (code_point & 0x3F);
+        return 3;
+    }
+
+    buffer[0] = 0xF0 | (code_point >> 18);
+    buffer[1] = 0x80 | ((code_point >> 12) & 0x3F);
+    buffer[2] = 0x80 | ((code_point >> 6) & 0x3F);
+    buffer[3] = 0x80 | (code_point & 0x3F);
+    return 4;
+}
+
 char *create_utf_array(char *word)
 {
     char *code = calloc((strlen_utf8(word) + 2), sizeof(char));
@@ -87,60 +161,156 @@ int min(int a, int b)
     return (a > b) ? b : a;
 }
 
-char *hyphenate_from_code(char *word, char *code)
+// Private utils.c function which clears breaks outside of hyphen minimums
+static int code_breaks_mask(int len_utf, uint64_t *breaks)
 {
-    int len = strlen(word);
-    int len_utf = strlen_utf8(word);
+    int first = min(left_hyphen_min, len_utf) + 1;
+    int last = len_utf - min(right_hyphen_min, len_utf) - 1;
     int hyphen_count = 0;
 
-    // left_hyphen_min
-    for (int i = 0; i < min(left_hyphen_min, len_utf) + 1; i++)
+    for (int w = 0; w < CODE_BREAK_WORDS(len_utf); w++)
     {
-        code[i] = 0;
-    }
+        int low = first - w * 64;
+        int high = last - w * 64;
 
-    // right_hyphen_min
-    for (int i = 0; i < min(right_hyphen_min, len_utf) + 1; i++)
-    {
-        code[len_utf - i] = 0;
+        if (high < 0 || low > 63 || low > high)
+            breaks[w] = 0;
+        else
+        {
+            if (low > 0)
+                breaks[w] &= ~0ULL << low;
+            if (high < 63)
+                breaks[w] &= ~(~0ULL << (high + 1));
+        }
+
+        hyphen_count += __builtin_popcountll(breaks[w]);
     }
 
-    if (verbose)
-        printf("Final hyphenation code: ");
+    return hyphen_count;
+}
 
-    for (int i = 1; i < len_utf; i++)
-    {
-        if (verbose)
-            printf("%i", code[i]);
+int code_breaks_scalar(const char *code, int len_utf, uint64_t *breaks)
+{
+    memset(breaks, 0, CODE_BREAK_WORDS(len_utf) * sizeof(uint64_t));
 
+    for (int i = 1; i < len_utf; i++)
         if (code[i] % 2 == 1)
-            hyphen_count++;
+            breaks[i / 64] |= 1ULL << (i % 64);
+
+    return code_breaks_mask(len_utf, breaks);
+}
+
+int code_breaks(const char *code, int len_utf, uint64_t *breaks)
+{
+#ifdef __SSE2__
+    memset(breaks, 0, CODE_BREAK_WORDS(len_utf) * sizeof(uint64_t));
+
+    // Lowest bit of every value is shifted to the highest bit of its byte
+    for (int i = 0; i < CODE_PADDED_SIZE(len_utf); i += CODE_VECTOR_SIZE)
+    {
+        __m128i values = _mm_loadu_si128((const __m128i *)&code[i]);
+        uint64_t odd = (uint16_t)_mm_movemask_epi8(_mm_slli_epi16(values, 7));
+        breaks[i / 64] |= odd << (i % 64);
     }
 
+    return code_breaks_mask(len_utf, breaks);
+#else
+    return code_breaks_scalar(code, len_utf, breaks);
+#endif
+}
+
+char *hyphenate_from_code(char *word, char *code)
+{
+    int len = strlen(word);
+    int len_utf = strlen_utf8(word);
+    uint64_t breaks[CODE_BREAK_WORDS(len_utf)];
+    int hyphen_count = code_breaks(code, len_utf, breaks);
+
     if (verbose)
+    {
+        printf("Final hyphenation code: ");
+
+        // Values outside of hyphen minimums are shown as 0
+        for (int i = 1; i < len_utf; i++)
+            printf("%i", i > min(left_hyphen_min, len_utf) &&
+                                 i < len_utf - min(right_hyphen_min, len_utf)
+                             ? code[i]
+                             : 0);
+
         printf("\n");
+    }
 
     char *result = calloc(len + hyphen_count + 1, sizeof(char));
 
+    // Bytes between breaks are copied at once, leading and trailing dots are skipped
     int result_index = 0;
-    int code_index = 1;
-    for (int i = 1; i < len - 1; i++)
+    int byte = 1;
+    int character = 1;
+    for (int w = 0; w < CODE_BREAK_WORDS(len_utf); w++)
     {
-        if ((word[i] & 0xF8) == 0xF0 || (word[i] & 0xF0) == 0xE0 ||
-            (word[i] & 0xE0) == 0xC0 || (word[i] >= 0 && word[i] <= 127))
+        for (uint64_t bits = breaks[w]; bits; bits &= bits - 1)
         {
-            if (code[code_index] % 2 == 1)
+            int position = w * 64 + __builtin_ctzll(bits);
+            int start = byte;
+
+            for (; character < position; character++)
             {
-                result[result_index] = hyphenation_char;
-                result_index++;
+                do
+                    byte++;
+                while ((word[byte] & 0xC0) == 0x80);
             }
 
-            code_index++;
+            memcpy(&result[result_index], &word[start], byte - start);
+            result_index += byte - start;
+            result[result_index++] = hyphenation_char;
         }
-
-        result[result_index] = word[i];
-        result_index++;
     }
 
+    memcpy(&result[result_index], &word[byte], len - 1 - byte);
+
     return result;
-}
\ No newline at end of file
+}
+
+size_t heap_usage(void)
+{
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+int cache_misses_start(void)
+{
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+
+    // There is no glibc wrapper for perf_event_open
+    int fd = syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+    if (fd == -1)
+        return -1;
+
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+
+    return fd;
+}
+
+long long cache_misses_stop(int fd)
+{
+    if (fd == -1)
+        return -1;
+
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+    long long count;
+    if (read(fd, &count, sizeof(count)) != sizeof(count))
+        count = -1;
+
+    close(fd);
+
+    return count;
+}